@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include "kengine.hpp"
+#include "reflection.hpp"
+
+// Attached to model entities whose saved components were modified by an editor since their last save
+struct DirtyComponent {
+	std::vector<kengine::EntityID> types; // Type entities of the modified components
+	bool all = false; // Set when the modified components are unknown
+};
+
+#define refltype DirtyComponent
+putils_reflection_info{
+	putils_reflection_class_name;
+	putils_reflection_attributes(
+		putils_reflection_attribute(types),
+		putils_reflection_attribute(all)
+	);
+};
+#undef refltype
+
+// Attached to DirtyComponent's type entity. Counts the components marked dirty, including those that already were
+struct DirtyGenerationComponent {
+	std::uint64_t generation = 0;
+};
+
+#define refltype DirtyGenerationComponent
+putils_reflection_info{
+	putils_reflection_class_name;
+	putils_reflection_attributes(
+		putils_reflection_attribute(generation)
+	);
+};
+#undef refltype
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include "reflection.hpp"
+
+// Name of the plugin (or "engine" for the systems created by the executable) that created the entity
+struct PluginComponent {
+	std::string name;
+};
+
+#define refltype PluginComponent
+putils_reflection_info{
+	putils_reflection_class_name;
+	putils_reflection_attributes(
+		putils_reflection_attribute(name)
+	);
+};
+#undef refltype
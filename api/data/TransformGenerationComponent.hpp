@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include "reflection.hpp"
+
+// Attached to TransformComponent's type entity. Counts the frames in which the picking plugin found model instances
+// that moved, appeared or were removed, as kengine doesn't report modified components
+struct TransformGenerationComponent {
+	std::uint64_t generation = 0;
+};
+
+#define refltype TransformGenerationComponent
+putils_reflection_info{
+	putils_reflection_class_name;
+	putils_reflection_attributes(
+		putils_reflection_attribute(generation)
+	);
+};
+#undef refltype
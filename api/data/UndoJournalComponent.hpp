@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "kengine.hpp"
+#include "reflection.hpp"
+
+// History of transform edits, filled and replayed through undoHelper
+struct UndoJournalComponent {
+	static constexpr size_t TRANSFORM_FIELD_COUNT = 9; // Position, size, yaw, pitch, roll
+
+	// One modified float of a TransformComponent. A step is made of the consecutive deltas following one with `stepStart` set
+	struct FieldDelta {
+		kengine::EntityID entity;
+		std::uint32_t generation; // Of the entity's UndoTargetComponent
+		std::int32_t collider; // Index in the entity's ModelColliderComponent, -1 for its TransformComponent
+		std::uint8_t field;
+		bool stepStart;
+		float before;
+		float after;
+	};
+
+	// Ring buffer of `capacity` deltas. Counters only grow, deltas are found at `counter % capacity`
+	std::vector<FieldDelta> deltas;
+	size_t capacity = 0;
+	size_t begin = 0; // Oldest delta
+	size_t cursor = 0; // Deltas in [begin, cursor) can be undone, those in [cursor, end) redone
+	size_t end = 0;
+
+	std::uint32_t nextGeneration = 1;
+
+	// Transform being dragged, recorded as a single step once the drag ends
+	struct PendingEdit {
+		kengine::EntityID entity;
+		std::uint32_t generation;
+		std::int32_t collider;
+		std::array<float, TRANSFORM_FIELD_COUNT> before;
+	};
+	std::vector<PendingEdit> pending;
+};
+
+#define refltype UndoJournalComponent
+putils_reflection_info{
+	putils_reflection_class_name;
+	putils_reflection_attributes(
+		putils_reflection_attribute(capacity),
+		putils_reflection_attribute(begin),
+		putils_reflection_attribute(cursor),
+		putils_reflection_attribute(end)
+	);
+};
+#undef refltype
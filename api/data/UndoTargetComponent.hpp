@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include "reflection.hpp"
+
+// Attached by undoHelper to the entities it journals. Removed entities lose it, so deltas recorded
+// for an entity whose id has since been reused are recognized by their generation and never applied
+struct UndoTargetComponent {
+	std::uint32_t generation = 0;
+};
+
+#define refltype UndoTargetComponent
+putils_reflection_info{
+	putils_reflection_class_name;
+	putils_reflection_attributes(
+		putils_reflection_attribute(generation)
+	);
+};
+#undef refltype
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "reflection.hpp"
+
+// Subscribes to content changes of files, as reported by the file watcher plugin
+struct WatchedFilesComponent {
+	std::vector<std::string> files;
+	std::function<void(const char * path)> onChange;
+};
+
+#define refltype WatchedFilesComponent
+putils_reflection_info{
+	putils_reflection_class_name;
+	putils_reflection_attributes(
+		putils_reflection_attribute(files),
+		putils_reflection_attribute(onChange)
+	);
+};
+#undef refltype
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "BaseFunction.hpp"
+
+namespace functions {
+	// Returns whether the system has work in progress (e.g. asynchronous loads), during which the editor shouldn't idle
+	struct IsBusy : kengine::functions::BaseFunction<
+		bool()
+	>
+	{};
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "BaseFunction.hpp"
+#include "kengine.hpp"
+
+namespace functions {
+	// Called by selectionHelper when `entity` gets selected or deselected
+	struct OnSelectionChanged : kengine::functions::BaseFunction<
+		void(kengine::EntityID entity, bool selected)
+	>
+	{};
+}
@@ -0,0 +1,44 @@
+#include "adjustableHelper.hpp"
+
+#include "kengine.hpp"
+#include "data/AdjustableComponent.hpp"
+
+namespace adjustableHelper {
+	using namespace kengine;
+
+	bool * findBool(std::string_view section, std::string_view name) noexcept {
+		for (const auto & [e, adjustable] : entities.with<AdjustableComponent>()) {
+			if (std::string_view(adjustable.section.c_str()) != section)
+				continue;
+
+			for (auto & value : adjustable.values)
+				if (std::string_view(value.name.c_str()) == name && value.boolStorage.ptr != nullptr)
+					return value.boolStorage.ptr;
+		}
+		return nullptr;
+	}
+
+	bool BoolOverride::set(bool value) noexcept {
+		// The pointer isn't kept, as the system exposing it may be removed before the override is restored
+		const auto ptr = findBool(_section, _name);
+		if (ptr == nullptr)
+			return false;
+
+		if (!_set)
+			_previous = *ptr;
+		*ptr = value;
+		_value = value;
+		_set = true;
+		return true;
+	}
+
+	void BoolOverride::restore() noexcept {
+		if (!_set)
+			return;
+		_set = false;
+
+		const auto ptr = findBool(_section, _name);
+		if (ptr != nullptr && *ptr == _value)
+			*ptr = _previous;
+	}
+}
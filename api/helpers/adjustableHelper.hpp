@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Access to the values other systems expose through their AdjustableComponent
+namespace adjustableHelper {
+	// Returns nullptr if no system exposes a boolean named `name` in `section`
+	bool * findBool(std::string_view section, std::string_view name) noexcept;
+
+	// Forces an adjustable boolean until `restore` is called, which gives it back the value it had.
+	// The user's setting is kept if they changed it in the meantime
+	class BoolOverride {
+	public:
+		BoolOverride(std::string_view section, std::string_view name) noexcept : _section(section), _name(name) {}
+
+		// Returns false if the boolean isn't exposed
+		bool set(bool value) noexcept;
+		void restore() noexcept;
+		bool isSet() const noexcept { return _set; }
+
+	private:
+		std::string _section;
+		std::string _name;
+		bool _set = false;
+		bool _value = false;
+		bool _previous = false;
+	};
+}
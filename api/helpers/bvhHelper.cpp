@@ -0,0 +1,232 @@
+#include "bvhHelper.hpp"
+
+#include <algorithm>
+
+namespace bvhHelper {
+	static AABB merge(const AABB & a, const AABB & b) noexcept {
+		return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+	}
+
+	static bool contains(const AABB & outer, const AABB & inner) noexcept {
+		return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
+	}
+
+	static float surfaceArea(const AABB & box) noexcept {
+		const auto size = box.max - box.min;
+		return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	std::optional<float> intersect(const AABB & box, const glm::vec3 & origin, const glm::vec3 & inverseDirection, float maxDistance) noexcept {
+		const auto t0 = (box.min - origin) * inverseDirection;
+		const auto t1 = (box.max - origin) * inverseDirection;
+		const auto tMin = glm::min(t0, t1);
+		const auto tMax = glm::max(t0, t1);
+
+		const auto enter = std::max({ tMin.x, tMin.y, tMin.z, 0.f });
+		const auto exit = std::min({ tMax.x, tMax.y, tMax.z, maxDistance });
+		if (enter > exit)
+			return std::nullopt;
+		return enter;
+	}
+
+	int Tree::insert(const AABB & box, kengine::EntityID entity) noexcept {
+		const auto leaf = allocateNode();
+		auto & node = _nodes[leaf];
+		node.box = { box.min - _margin, box.max + _margin };
+		node.entity = entity;
+		node.height = 0;
+
+		insertLeaf(leaf);
+		++_leafCount;
+		return leaf;
+	}
+
+	void Tree::remove(int proxy) noexcept {
+		removeLeaf(proxy);
+		freeNode(proxy);
+		--_leafCount;
+	}
+
+	bool Tree::update(int proxy, const AABB & box) noexcept {
+		if (contains(_nodes[proxy].box, box))
+			return false;
+
+		removeLeaf(proxy);
+		_nodes[proxy].box = { box.min - _margin, box.max + _margin };
+		insertLeaf(proxy);
+		return true;
+	}
+
+	int Tree::allocateNode() noexcept {
+		if (_freeList == NULL_NODE) {
+			_nodes.emplace_back();
+			return (int)_nodes.size() - 1;
+		}
+
+		const auto index = _freeList;
+		_freeList = _nodes[index].parent;
+		_nodes[index] = Node{};
+		return index;
+	}
+
+	void Tree::freeNode(int index) noexcept {
+		auto & node = _nodes[index];
+		node.parent = _freeList;
+		node.left = NULL_NODE;
+		node.right = NULL_NODE;
+		node.height = -1;
+		node.entity = kengine::INVALID_ID;
+		_freeList = index;
+	}
+
+	void Tree::insertLeaf(int leaf) noexcept {
+		if (_root == NULL_NODE) {
+			_root = leaf;
+			_nodes[leaf].parent = NULL_NODE;
+			return;
+		}
+
+		// Descend towards the sibling which minimizes the total surface area of the tree
+		const auto leafBox = _nodes[leaf].box;
+		auto index = _root;
+		while (!_nodes[index].isLeaf()) {
+			const auto & node = _nodes[index];
+			const auto area = surfaceArea(node.box);
+			const auto combinedArea = surfaceArea(merge(node.box, leafBox));
+
+			// Cost of pairing the leaf with this node, and cost pushed down to the children by doing so
+			const auto cost = 2.f * combinedArea;
+			const auto inheritanceCost = 2.f * (combinedArea - area);
+
+			const auto childCost = [&](int child) noexcept {
+				const auto & childBox = _nodes[child].box;
+				const auto mergedArea = surfaceArea(merge(leafBox, childBox));
+				if (_nodes[child].isLeaf())
+					return mergedArea + inheritanceCost;
+				return mergedArea - surfaceArea(childBox) + inheritanceCost;
+			};
+			const auto leftCost = childCost(node.left);
+			const auto rightCost = childCost(node.right);
+
+			if (cost < leftCost && cost < rightCost)
+				break;
+			index = leftCost < rightCost ? node.left : node.right;
+		}
+
+		const auto sibling = index;
+		const auto oldParent = _nodes[sibling].parent;
+		const auto newParent = allocateNode();
+
+		auto & parent = _nodes[newParent];
+		parent.parent = oldParent;
+		parent.box = merge(leafBox, _nodes[sibling].box);
+		parent.height = _nodes[sibling].height + 1;
+		parent.left = sibling;
+		parent.right = leaf;
+		_nodes[sibling].parent = newParent;
+		_nodes[leaf].parent = newParent;
+
+		if (oldParent == NULL_NODE)
+			_root = newParent;
+		else if (_nodes[oldParent].left == sibling)
+			_nodes[oldParent].left = newParent;
+		else
+			_nodes[oldParent].right = newParent;
+
+		refit(_nodes[leaf].parent);
+	}
+
+	void Tree::removeLeaf(int leaf) noexcept {
+		if (leaf == _root) {
+			_root = NULL_NODE;
+			return;
+		}
+
+		const auto parent = _nodes[leaf].parent;
+		const auto grandParent = _nodes[parent].parent;
+		const auto sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+		_nodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		if (grandParent == NULL_NODE) {
+			_root = sibling;
+			return;
+		}
+
+		if (_nodes[grandParent].left == parent)
+			_nodes[grandParent].left = sibling;
+		else
+			_nodes[grandParent].right = sibling;
+		refit(grandParent);
+	}
+
+	// Rebalances and recomputes the boxes and heights from `index` up to the root
+	void Tree::refit(int index) noexcept {
+		while (index != NULL_NODE) {
+			index = balance(index);
+
+			auto & node = _nodes[index];
+			const auto & left = _nodes[node.left];
+			const auto & right = _nodes[node.right];
+			node.height = 1 + std::max(left.height, right.height);
+			node.box = merge(left.box, right.box);
+
+			index = node.parent;
+		}
+	}
+
+	// Returns the index of the node now at `index`'s position
+	int Tree::balance(int index) noexcept {
+		const auto & node = _nodes[index];
+		if (node.isLeaf() || node.height < 2)
+			return index;
+
+		const auto balanceFactor = _nodes[node.right].height - _nodes[node.left].height;
+		if (balanceFactor > 1)
+			return rotate(index, node.right, node.left);
+		if (balanceFactor < -1)
+			return rotate(index, node.left, node.right);
+		return index;
+	}
+
+	// Promotes `child`, the taller child of `index`, in its place. `other` is `index`'s other child
+	int Tree::rotate(int index, int child, int other) noexcept {
+		auto & a = _nodes[index];
+		auto & c = _nodes[child];
+
+		const auto grandChildLeft = c.left;
+		const auto grandChildRight = c.right;
+
+		c.left = index;
+		c.parent = a.parent;
+		a.parent = child;
+
+		if (c.parent == NULL_NODE)
+			_root = child;
+		else if (_nodes[c.parent].left == index)
+			_nodes[c.parent].left = child;
+		else
+			_nodes[c.parent].right = child;
+
+		// The taller grandchild stays under `child`, the other one takes its place under `index`
+		auto kept = grandChildLeft;
+		auto given = grandChildRight;
+		if (_nodes[grandChildLeft].height < _nodes[grandChildRight].height)
+			std::swap(kept, given);
+
+		c.right = kept;
+		if (a.left == child)
+			a.left = given;
+		else
+			a.right = given;
+		_nodes[given].parent = index;
+
+		a.box = merge(_nodes[other].box, _nodes[given].box);
+		a.height = 1 + std::max(_nodes[other].height, _nodes[given].height);
+		c.box = merge(a.box, _nodes[kept].box);
+		c.height = 1 + std::max(a.height, _nodes[kept].height);
+
+		return child;
+	}
+}
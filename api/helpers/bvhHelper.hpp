@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <glm/glm.hpp>
+
+#include "kengine.hpp"
+
+// Dynamic AABB tree for CPU-side ray casts over entities
+namespace bvhHelper {
+	struct AABB {
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	// Returns the distance along the ray at which it enters `box`, if it does so before `maxDistance`.
+	// `inverseDirection` is 1 / direction, so that it's only computed once per ray
+	std::optional<float> intersect(const AABB & box, const glm::vec3 & origin, const glm::vec3 & inverseDirection, float maxDistance) noexcept;
+
+	// Leaves are stored enlarged by `margin`, so that small moves don't require a reinsertion.
+	// Insertions pick the sibling with the smallest surface area increase and the tree is kept balanced by rotations
+	class Tree {
+	public:
+		static constexpr int NULL_NODE = -1;
+
+		Tree(float margin = .1f) noexcept : _margin(margin) {}
+
+		// Returns the proxy identifying the leaf
+		int insert(const AABB & box, kengine::EntityID entity) noexcept;
+		void remove(int proxy) noexcept;
+		// Returns whether the leaf had to be reinserted, i.e. whether `box` left its enlarged box
+		bool update(int proxy, const AABB & box) noexcept;
+
+		kengine::EntityID getEntity(int proxy) const noexcept { return _nodes[proxy].entity; }
+		size_t size() const noexcept { return _leafCount; }
+
+		// Calls `hit(entity, maxDistance)` for leaves whose box the ray enters before `maxDistance`.
+		// `hit` returns the distance at which the entity was hit, or `maxDistance` if it was missed.
+		// The nearer child of each node is visited first, so that subtrees beyond the closest hit found so far are skipped
+		template<typename Hit>
+		void raycast(const glm::vec3 & origin, const glm::vec3 & direction, float maxDistance, Hit && hit) const noexcept;
+
+	private:
+		struct Node {
+			AABB box;
+			int parent = NULL_NODE; // Next free node when in the free list
+			int left = NULL_NODE;
+			int right = NULL_NODE;
+			int height = 0; // Leaves are at 0, -1 for free nodes
+			kengine::EntityID entity = kengine::INVALID_ID;
+
+			bool isLeaf() const noexcept { return left == NULL_NODE; }
+		};
+
+		int allocateNode() noexcept;
+		void freeNode(int index) noexcept;
+		void insertLeaf(int leaf) noexcept;
+		void removeLeaf(int leaf) noexcept;
+		void refit(int index) noexcept;
+		int balance(int index) noexcept;
+		int rotate(int index, int child, int other) noexcept;
+
+	private:
+		std::vector<Node> _nodes;
+		int _root = NULL_NODE;
+		int _freeList = NULL_NODE;
+		size_t _leafCount = 0;
+		float _margin;
+	};
+}
+
+template<typename Hit>
+void bvhHelper::Tree::raycast(const glm::vec3 & origin, const glm::vec3 & direction, float maxDistance, Hit && hit) const noexcept {
+	if (_root == NULL_NODE)
+		return;
+
+	const auto inverseDirection = 1.f / direction;
+
+	const auto rootDistance = intersect(_nodes[_root].box, origin, inverseDirection, maxDistance);
+	if (!rootDistance)
+		return;
+
+	// Nodes with the distance at which the ray enters them, which may be beyond a hit found since they were pushed
+	struct Entry {
+		int node;
+		float distance;
+	};
+
+	std::vector<Entry> stack;
+	stack.reserve(64);
+	stack.push_back({ _root, *rootDistance });
+	while (!stack.empty()) {
+		const auto entry = stack.back();
+		stack.pop_back();
+		if (entry.distance > maxDistance)
+			continue;
+
+		const auto & node = _nodes[entry.node];
+		if (node.isLeaf()) {
+			maxDistance = hit(node.entity, maxDistance);
+			continue;
+		}
+
+		const auto left = intersect(_nodes[node.left].box, origin, inverseDirection, maxDistance);
+		const auto right = intersect(_nodes[node.right].box, origin, inverseDirection, maxDistance);
+		if (left && right) {
+			// The farther child is pushed first, so that the nearer one is popped next
+			const bool leftFirst = *left <= *right;
+			stack.push_back(leftFirst ? Entry{ node.right, *right } : Entry{ node.left, *left });
+			stack.push_back(leftFirst ? Entry{ node.left, *left } : Entry{ node.right, *right });
+		}
+		else if (left)
+			stack.push_back({ node.left, *left });
+		else if (right)
+			stack.push_back({ node.right, *right });
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <algorithm>
+#include "kengine.hpp"
+#include "data/DirtyComponent.hpp"
+#include "helpers/typeHelper.hpp"
+
+// Editors flag the components they modify, so that systems can notice edits.
+// Saves don't rely on it, as plugins and scripts may modify components without flagging them
+namespace dirtyHelper {
+	// Kept in the entity pools rather than in a static, as each plugin links its own copy of the api
+	inline DirtyGenerationComponent & getGenerationComponent() noexcept {
+		return kengine::typeHelper::getTypeEntity<DirtyComponent>().attach<DirtyGenerationComponent>();
+	}
+
+	// Changes whenever a component is marked dirty, so that systems can notice edits of components that already were
+	inline std::uint64_t getGeneration() noexcept {
+		return getGenerationComponent().generation;
+	}
+
+	template<typename Comp>
+	void markDirty(kengine::Entity & model) noexcept {
+		++getGenerationComponent().generation;
+		auto & dirty = model.attach<DirtyComponent>();
+		const auto type = kengine::typeHelper::getTypeEntity<Comp>().id;
+		if (std::find(dirty.types.begin(), dirty.types.end(), type) == dirty.types.end())
+			dirty.types.push_back(type);
+	}
+
+	inline void markAllDirty(kengine::Entity & model) noexcept {
+		++getGenerationComponent().generation;
+		model.attach<DirtyComponent>().all = true;
+	}
+}
@@ -0,0 +1,170 @@
+#include "fileWatcherHelper.hpp"
+
+#include <unordered_set>
+
+#ifdef __linux__
+# include <sys/inotify.h>
+# include <unistd.h>
+# include <cerrno>
+#endif
+
+#include "kengine.hpp"
+#include "hashHelper.hpp"
+
+namespace fileWatcherHelper {
+	namespace fs = std::filesystem;
+
+	static std::future<std::optional<std::uint64_t>> hashAsync(const std::string & path) noexcept {
+		return kengine::threadPool().runTask([path]() noexcept {
+			return hashHelper::hashFile(path.c_str());
+		});
+	}
+
+	Watcher::Watcher() noexcept {
+#ifdef __linux__
+		_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	}
+
+	Watcher::~Watcher() noexcept {
+#ifdef __linux__
+		if (_fd >= 0)
+			close(_fd);
+#endif
+	}
+
+	void Watcher::setFiles(const std::vector<std::string> & files) noexcept {
+		const std::unordered_set<std::string> wanted(files.begin(), files.end());
+
+		std::vector<std::string> toRemove;
+		for (const auto & [path, file] : _files)
+			if (!wanted.contains(path))
+				toRemove.push_back(path);
+		for (const auto & path : toRemove)
+			removeFile(path);
+
+		for (const auto & path : wanted)
+			if (!_files.contains(path))
+				addFile(path);
+	}
+
+	void Watcher::addFile(const std::string & path) noexcept {
+		File file;
+		file.hashing = hashAsync(path);
+
+#ifdef __linux__
+		// Watch the directory rather than the file, as editors often save by replacing the file
+		const auto directory = fs::path(path).parent_path().string();
+		auto it = _directories.find(directory);
+		if (it == _directories.end() && _fd >= 0) {
+			const auto wd = inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE);
+			if (wd >= 0) {
+				it = _directories.emplace(directory, Directory{ wd, 0 }).first;
+				_directoryByWd[wd] = directory;
+			}
+		}
+		if (it != _directories.end())
+			++it->second.fileCount;
+#else
+		std::error_code error;
+		file.lastWrite = fs::last_write_time(path, error);
+#endif
+
+		_files.emplace(path, std::move(file));
+	}
+
+	void Watcher::removeFile(const std::string & path) noexcept {
+		_files.erase(path);
+
+#ifdef __linux__
+		const auto directory = fs::path(path).parent_path().string();
+		const auto it = _directories.find(directory);
+		if (it == _directories.end())
+			return;
+
+		if (--it->second.fileCount > 0)
+			return;
+
+		inotify_rm_watch(_fd, it->second.wd);
+		_directoryByWd.erase(it->second.wd);
+		_directories.erase(it);
+#endif
+	}
+
+	void Watcher::readEvents() noexcept {
+		const auto now = Clock::now();
+
+#ifdef __linux__
+		if (_fd < 0)
+			return;
+
+		alignas(inotify_event) char buffer[16 * 1024];
+		while (true) {
+			const auto length = read(_fd, buffer, sizeof(buffer));
+			if (length <= 0)
+				break;
+
+			for (ssize_t offset = 0; offset < length;) {
+				const auto event = (const inotify_event *)(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				if (event->len == 0)
+					continue;
+
+				const auto directory = _directoryByWd.find(event->wd);
+				if (directory == _directoryByWd.end())
+					continue;
+
+				const auto path = (fs::path(directory->second) / event->name).string();
+				const auto file = _files.find(path);
+				if (file == _files.end())
+					continue;
+
+				file->second.pending = true;
+				file->second.lastEvent = now;
+			}
+		}
+#else
+		for (auto & [path, file] : _files) {
+			std::error_code error;
+			const auto lastWrite = fs::last_write_time(path, error);
+			if (error || lastWrite == file.lastWrite)
+				continue;
+			file.lastWrite = lastWrite;
+			file.pending = true;
+			file.lastEvent = now;
+		}
+#endif
+	}
+
+	std::vector<std::string> Watcher::poll(std::chrono::milliseconds debounce) noexcept {
+		readEvents();
+
+		std::vector<std::string> ret;
+
+		const auto now = Clock::now();
+		for (auto & [path, file] : _files) {
+			if (file.hashing.valid() && file.hashing.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+				const auto hash = file.hashing.get();
+				if (file.initial) {
+					file.hash = hash ? *hash : 0;
+					file.initial = false;
+				}
+				// Files can be touched or rewritten with the same contents
+				else if (hash && *hash != file.hash) {
+					file.hash = *hash;
+					ret.push_back(path);
+				}
+			}
+
+			// Events received while hashing are handled once it's done
+			if (file.hashing.valid() || !file.pending || now - file.lastEvent < debounce)
+				continue;
+
+			file.pending = false;
+			file.hashing = hashAsync(path);
+		}
+
+		return ret;
+	}
+}
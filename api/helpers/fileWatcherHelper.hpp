@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <optional>
+#include <unordered_map>
+#include <filesystem>
+
+namespace fileWatcherHelper {
+	// Watches files for content changes. Uses inotify on Linux and falls back to polling modification times elsewhere.
+	// Files are hashed on the thread pool, so a change is reported by the first poll after its file was hashed
+	class Watcher {
+	public:
+		Watcher() noexcept;
+		~Watcher() noexcept;
+
+		Watcher(const Watcher &) = delete;
+		Watcher & operator=(const Watcher &) = delete;
+
+		// Paths should be absolute and normalized
+		void setFiles(const std::vector<std::string> & files) noexcept;
+
+		// Returns the files whose contents changed and which haven't been touched for `debounce`
+		std::vector<std::string> poll(std::chrono::milliseconds debounce) noexcept;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct File {
+			std::uint64_t hash = 0;
+			bool initial = true; // Set until the hash the file had when it started being watched is known
+			std::future<std::optional<std::uint64_t>> hashing; // Valid while the file is being hashed
+			bool pending = false;
+			Clock::time_point lastEvent;
+#ifndef __linux__
+			std::filesystem::file_time_type lastWrite;
+#endif
+		};
+
+		void addFile(const std::string & path) noexcept;
+		void removeFile(const std::string & path) noexcept;
+		void readEvents() noexcept;
+
+	private:
+		std::unordered_map<std::string, File> _files;
+
+#ifdef __linux__
+		int _fd = -1;
+		struct Directory {
+			int wd;
+			size_t fileCount;
+		};
+		std::unordered_map<std::string, Directory> _directories;
+		std::unordered_map<int, std::string> _directoryByWd;
+#endif
+	};
+}
@@ -1,5 +1,6 @@
 #include <GLFW/glfw3.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <optional>
 #include "gizmoHelper.hpp"
 
 #include "data/InstanceComponent.hpp"
@@ -20,17 +21,29 @@ namespace gizmoHelper {
 	static bool g_uniformScale = true;
 	float putils::Point3f:: * g_currentScaleModifier = nullptr;
 
+	// Ids only restart with a new ImGui frame, so that systems of the same module calling newFrame during a frame get distinct ones
 	static size_t g_gizmoId = 0;
+	static int g_gizmoFrame = -1;
+	static std::optional<size_t> g_manipulatedGizmo;
 
 	void newFrame(const ImVec2 & windowSize, const ImVec2 & windowPos) noexcept {
-		g_gizmoId = 0;
+		if (g_gizmoFrame != ImGui::GetFrameCount()) {
+			g_gizmoFrame = ImGui::GetFrameCount();
+			g_gizmoId = 0;
+		}
 		ImGuizmo::BeginFrame();
 		ImGuizmo::SetDrawlist();
 		ImGuizmo::SetRect(windowPos.x, windowPos.y, windowSize.x, windowSize.y);
 	}
 
-	void drawGizmo(kengine::TransformComponent & transform, const glm::mat4 & proj, const glm::mat4 & view, const glm::mat4 * parentMat, bool revertParentBeforeTransform) noexcept {
-		ImGuizmo::SetID(g_gizmoId++);
+	bool drawGizmo(kengine::TransformComponent & transform, const glm::mat4 & proj, const glm::mat4 & view, const glm::mat4 * parentMat, bool revertParentBeforeTransform) noexcept {
+		const auto id = g_gizmoId++;
+		ImGuizmo::SetID((int)id);
+
+		// ImGuizmo starts using a gizmo during the Manipulate call of the one that was clicked
+		const auto wasUsing = ImGuizmo::IsUsing();
+		if (!wasUsing)
+			g_manipulatedGizmo = std::nullopt;
 
 		auto matrix = matrixHelper::getModelMatrix(transform);
 		if (parentMat)
@@ -85,8 +98,14 @@ namespace gizmoHelper {
 			break;
 		}
 
-		if (!ImGuizmo::IsUsing())
+		if (!ImGuizmo::IsUsing()) {
 			g_currentScaleModifier = nullptr;
+			return false;
+		}
+
+		if (!wasUsing)
+			g_manipulatedGizmo = id;
+		return g_manipulatedGizmo == id;
 	}
 
 	void handleContextMenu(const std::function<void()> & displayContextMenu) noexcept {
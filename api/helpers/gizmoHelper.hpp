@@ -13,6 +13,7 @@ namespace gizmoHelper {
 	};
 
 	void newFrame(const ImVec2 & windowSize, const ImVec2 & windowPos) noexcept;
-	void drawGizmo(kengine::TransformComponent & transform, const glm::mat4 & proj, const glm::mat4 & view, const glm::mat4 * parentMatrix = nullptr, bool revertParentMatrixBeforeTransform = false) noexcept;
+	// Returns whether this gizmo is the one being manipulated, unlike ImGuizmo::IsUsing which is true while any gizmo is
+	bool drawGizmo(kengine::TransformComponent & transform, const glm::mat4 & proj, const glm::mat4 & view, const glm::mat4 * parentMatrix = nullptr, bool revertParentMatrixBeforeTransform = false) noexcept;
 	void handleContextMenu(const std::function<void()> & displayContextMenu = nullptr) noexcept;
 }
\ No newline at end of file
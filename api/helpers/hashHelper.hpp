@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <fstream>
+#include <vector>
+
+// 64-bit FNV-1a, used to detect content changes. Not meant to be cryptographically secure
+namespace hashHelper {
+	static constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+	static constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+	inline void hashBytes(std::uint64_t & hash, const void * data, size_t size) noexcept {
+		const auto bytes = (const std::uint8_t *)data;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+	}
+
+	inline std::optional<std::uint64_t> hashFile(const char * path) noexcept {
+		std::ifstream f(path, std::ifstream::binary);
+		if (!f)
+			return std::nullopt;
+
+		std::uint64_t hash = FNV_OFFSET;
+		std::vector<char> buffer(64 * 1024);
+		while (f) {
+			f.read(buffer.data(), buffer.size());
+			hashBytes(hash, buffer.data(), (size_t)f.gcount());
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,299 @@
+#include "importCacheHelper.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+
+#include <assimp/Importer.hpp>
+#include <assimp/Exporter.hpp>
+#include <assimp/scene.h>
+#include <assimp/version.h>
+
+#include "kengine.hpp"
+#include "hashHelper.hpp"
+#include "file_extension.hpp"
+
+namespace importCacheHelper {
+	namespace fs = std::filesystem;
+
+	static constexpr std::uint64_t CACHE_VERSION = 1;
+	static constexpr auto COOKED_FORMAT = "assbin";
+	// The AssImpSystem applies its own post-processing when loading the cooked file, so none is baked in
+	static constexpr unsigned int IMPORT_FLAGS = 0;
+	static constexpr size_t CHUNK_SIZE = 1024 * 1024;
+
+	using hashHelper::hashBytes;
+
+	static std::atomic<size_t> g_cacheSize = 0;
+	static std::once_flag g_cacheSizeComputed;
+
+	// Cooked files being written by background cooks
+	static std::unordered_set<std::string> g_cooking;
+	static std::mutex g_cookingMutex;
+	static std::condition_variable g_cookFinished;
+
+	static std::optional<std::uint64_t> hashFile(const char * path, const ProgressCallback & onProgress) noexcept {
+		std::ifstream f(path, std::ifstream::binary);
+		if (!f)
+			return std::nullopt;
+
+		std::error_code error;
+		const auto size = fs::file_size(path, error);
+		if (error)
+			return std::nullopt;
+
+		std::uint64_t hash = hashHelper::FNV_OFFSET;
+		std::vector<char> buffer(std::min(CHUNK_SIZE, (size_t)size));
+		size_t read = 0;
+		while (read < size) {
+			// Hashing reads the whole file, which is most of the time spent on a cache hit
+			if (onProgress != nullptr && !onProgress(.5f * (float)read / (float)size))
+				return std::nullopt;
+
+			f.read(buffer.data(), buffer.size());
+			const auto count = (size_t)f.gcount();
+			if (count == 0)
+				break;
+			hashBytes(hash, buffer.data(), count);
+			read += count;
+		}
+
+		if (read != size)
+			return std::nullopt;
+		return hash;
+	}
+
+	static std::uint64_t hashSettings(std::string_view extension) noexcept {
+		std::uint64_t hash = hashHelper::FNV_OFFSET;
+		const std::uint64_t settings[] = {
+			CACHE_VERSION, IMPORT_FLAGS,
+			aiGetVersionMajor(), aiGetVersionMinor(), aiGetVersionRevision()
+		};
+		hashBytes(hash, settings, sizeof(settings));
+		// The source format picks the importer
+		hashBytes(hash, extension.data(), extension.size());
+		return hash;
+	}
+
+	static std::string toHex(std::uint64_t value) noexcept {
+		static constexpr char digits[] = "0123456789abcdef";
+		std::string ret(16, '0');
+		for (int i = 15; i >= 0; --i) {
+			ret[i] = digits[value & 0xf];
+			value >>= 4;
+		}
+		return ret;
+	}
+
+	// The cooked file doesn't live next to the source, so relative texture paths are made absolute
+	static void makeTexturePathsAbsolute(aiScene & scene, const fs::path & sourceDirectory) noexcept {
+		for (unsigned int m = 0; m < scene.mNumMaterials; ++m) {
+			const auto material = scene.mMaterials[m];
+			for (int type = aiTextureType_NONE; type <= aiTextureType_UNKNOWN; ++type) {
+				const auto textureType = (aiTextureType)type;
+				for (unsigned int i = 0; i < material->GetTextureCount(textureType); ++i) {
+					aiString texturePath;
+					if (material->GetTexture(textureType, i, &texturePath) != AI_SUCCESS)
+						continue;
+
+					// Embedded textures are referenced as "*index"
+					if (texturePath.length == 0 || texturePath.data[0] == '*')
+						continue;
+
+					const fs::path relative(texturePath.C_Str());
+					if (relative.is_absolute())
+						continue;
+
+					const aiString absolute((sourceDirectory / relative).lexically_normal().string());
+					material->AddProperty(&absolute, AI_MATKEY_TEXTURE(textureType, i));
+				}
+			}
+		}
+	}
+
+	static bool cook(const char * path, const fs::path & destination) noexcept {
+		Assimp::Importer importer;
+		if (importer.ReadFile(path, IMPORT_FLAGS) == nullptr)
+			return false;
+
+		const std::unique_ptr<aiScene> scene(importer.GetOrphanedScene());
+		makeTexturePathsAbsolute(*scene, fs::absolute(path).parent_path());
+
+		// Write to a temporary file so that concurrent loads never see a partial file
+		auto tmp = destination;
+		tmp += ".tmp";
+
+		Assimp::Exporter exporter;
+		if (exporter.Export(scene.get(), COOKED_FORMAT, tmp.string()) != AI_SUCCESS)
+			return false;
+
+		std::error_code error;
+		fs::rename(tmp, destination, error);
+		if (error)
+			return false;
+
+		const auto size = fs::file_size(destination, error);
+		if (!error)
+			g_cacheSize += (size_t)size;
+		return true;
+	}
+
+	static void evict(size_t maxCacheSize) noexcept {
+		struct Entry {
+			fs::path path;
+			size_t size;
+			fs::file_time_type lastUsed;
+		};
+
+		std::vector<Entry> entries;
+		size_t total = 0;
+
+		std::error_code error;
+		for (const auto & file : fs::directory_iterator(DIRECTORY, error)) {
+			if (!file.is_regular_file(error) || file.path().extension() == ".tmp")
+				continue;
+			const Entry entry{ file.path(), (size_t)file.file_size(error), file.last_write_time(error) };
+			total += entry.size;
+			entries.push_back(entry);
+		}
+
+		g_cacheSize = total;
+		if (total <= maxCacheSize)
+			return;
+
+		std::sort(entries.begin(), entries.end(), [](const Entry & lhs, const Entry & rhs) noexcept {
+			return lhs.lastUsed < rhs.lastUsed;
+		});
+
+		for (const auto & entry : entries) {
+			if (total <= maxCacheSize)
+				break;
+			if (fs::remove(entry.path, error))
+				total -= entry.size;
+		}
+		g_cacheSize = total;
+	}
+
+	static std::optional<fs::path> getCachePath(const char * path, const ProgressCallback & onProgress) noexcept {
+		const auto contentHash = hashFile(path, onProgress);
+		if (!contentHash)
+			return std::nullopt;
+
+		const auto settingsHash = hashSettings(putils::file_extension(path));
+		return fs::path(DIRECTORY) / (toHex(*contentHash) + '-' + toHex(settingsHash) + '.' + COOKED_FORMAT);
+	}
+
+	// Eviction is least recently used first
+	static bool touch(const fs::path & cached) noexcept {
+		std::error_code error;
+		if (!fs::exists(cached, error))
+			return false;
+		fs::last_write_time(cached, fs::file_time_type::clock::now(), error);
+		return true;
+	}
+
+	static bool cookAndEvict(const char * path, const fs::path & cached, size_t maxCacheSize) noexcept {
+		std::error_code error;
+		fs::create_directories(DIRECTORY, error);
+		if (!cook(path, cached))
+			return false;
+
+		evict(maxCacheSize);
+		return true;
+	}
+
+	std::optional<std::string> getCachedImport(const char * path, size_t maxCacheSize, const ProgressCallback & onProgress) noexcept {
+		const auto cached = getCachePath(path, onProgress);
+		if (!cached)
+			return std::nullopt;
+
+		if (!touch(*cached)) {
+			if (onProgress != nullptr && !onProgress(.5f))
+				return std::nullopt;
+			if (!cookAndEvict(path, *cached, maxCacheSize))
+				return std::nullopt;
+		}
+
+		if (onProgress != nullptr)
+			onProgress(1.f);
+		return cached->string();
+	}
+
+	std::optional<std::string> findCachedImport(const char * path, size_t maxCacheSize, const ProgressCallback & onProgress) noexcept {
+		const auto cached = getCachePath(path, onProgress);
+		if (!cached)
+			return std::nullopt;
+
+		if (touch(*cached)) {
+			if (onProgress != nullptr)
+				onProgress(1.f);
+			return cached->string();
+		}
+
+		{
+			const std::lock_guard lock(g_cookingMutex);
+			if (!g_cooking.insert(cached->string()).second)
+				return std::nullopt;
+		}
+
+		kengine::threadPool().runTask([source = std::string(path), cached = *cached, maxCacheSize]() noexcept {
+			cookAndEvict(source.c_str(), cached, maxCacheSize);
+
+			const std::lock_guard lock(g_cookingMutex);
+			g_cooking.erase(cached.string());
+			g_cookFinished.notify_all();
+		});
+		return std::nullopt;
+	}
+
+	void waitForCooks() noexcept {
+		std::unique_lock lock(g_cookingMutex);
+		g_cookFinished.wait(lock, [] { return g_cooking.empty(); });
+	}
+
+	bool isCacheable(std::string_view path) noexcept {
+		Assimp::Importer importer;
+		const std::string extension(putils::file_extension(path));
+		return importer.IsExtensionSupported('.' + extension);
+	}
+
+	size_t getCacheSize() noexcept {
+		std::call_once(g_cacheSizeComputed, [] {
+			size_t total = 0;
+			std::error_code error;
+			for (const auto & file : fs::directory_iterator(DIRECTORY, error))
+				if (file.is_regular_file(error) && file.path().extension() != ".tmp")
+					total += (size_t)file.file_size(error);
+			g_cacheSize = total;
+		});
+		return g_cacheSize;
+	}
+
+	void purge(const std::unordered_set<std::string> & keep) noexcept {
+		std::unordered_set<std::string> kept;
+		for (const auto & path : keep)
+			kept.insert(fs::path(path).lexically_normal().string());
+
+		size_t total = 0;
+		std::error_code error;
+		for (const auto & file : fs::directory_iterator(DIRECTORY, error)) {
+			if (!file.is_regular_file(error))
+				continue;
+
+			// Temporary files are being written by cooks, which rename them once done
+			const auto & path = file.path();
+			if (path.extension() == ".tmp")
+				continue;
+
+			const auto size = (size_t)file.file_size(error);
+			if (kept.contains(path.lexically_normal().string()) || !fs::remove(path, error))
+				total += size;
+		}
+		g_cacheSize = total;
+	}
+}
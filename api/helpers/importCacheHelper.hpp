@@ -0,0 +1,33 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <functional>
+#include <unordered_set>
+
+// On-disk cache of imported assets, keyed by the content hash of the source file and the importer settings.
+// Assets are cooked into Assimp's binary format (.assbin), which the AssImpSystem loads without going
+// through the source format's parser. Its post-processing still runs on the cooked scene
+namespace importCacheHelper {
+	static constexpr auto DIRECTORY = "importCache";
+
+	// Called with the proportion of the source file processed so far. Returning false aborts
+	using ProgressCallback = std::function<bool(float progress)>;
+
+	// Returns the path to the cooked version of `path`, cooking it if needed.
+	// Returns std::nullopt if the file couldn't be read, the cook failed or `onProgress` aborted it
+	std::optional<std::string> getCachedImport(const char * path, size_t maxCacheSize, const ProgressCallback & onProgress = nullptr) noexcept;
+
+	// Returns the path to the cooked version of `path` if it is already cached. Otherwise, its cook is started on the thread pool
+	// and std::nullopt is returned, so that the caller imports the source rather than paying for an import and an export first
+	std::optional<std::string> findCachedImport(const char * path, size_t maxCacheSize, const ProgressCallback & onProgress = nullptr) noexcept;
+	// Blocks until the cooks started by findCachedImport are done, e.g. before the module running them is unloaded
+	void waitForCooks() noexcept;
+
+	bool isCacheable(std::string_view path) noexcept;
+
+	// The directory is only walked by the first call, the size is then kept up to date by cooks, evictions and purges
+	size_t getCacheSize() noexcept;
+	// Removes the cooked files except those in `keep`, which are still referenced. Cooks in progress aren't affected
+	void purge(const std::unordered_set<std::string> & keep = {}) noexcept;
+}
@@ -0,0 +1,155 @@
+#include "jsonStreamHelper.hpp"
+
+#include <vector>
+#include <streambuf>
+
+namespace jsonStreamHelper {
+	namespace {
+		// Builds one element at a time from nlohmann's SAX events
+		class ElementBuilder {
+		public:
+			using number_integer_t = putils::json::number_integer_t;
+			using number_unsigned_t = putils::json::number_unsigned_t;
+			using number_float_t = putils::json::number_float_t;
+			using string_t = putils::json::string_t;
+			using binary_t = putils::json::binary_t;
+
+			ElementBuilder(const ElementCallback & onElement) noexcept
+				: _onElement(onElement)
+			{}
+
+			bool null() { return add(nullptr); }
+			bool boolean(bool val) { return add(val); }
+			bool number_integer(number_integer_t val) { return add(val); }
+			bool number_unsigned(number_unsigned_t val) { return add(val); }
+			bool number_float(number_float_t val, const string_t &) { return add(val); }
+			bool string(string_t & val) { return add(std::move(val)); }
+			bool binary(binary_t & val) { return add(putils::json::binary(std::move(val))); }
+
+			bool start_object(std::size_t) { return open(putils::json::object()); }
+			bool end_object() { return close(); }
+
+			bool start_array(std::size_t) {
+				if (_stack.empty() && !_inTopLevelArray && !_startedTopLevel) {
+					_startedTopLevel = true;
+					_inTopLevelArray = true;
+					return true;
+				}
+				return open(putils::json::array());
+			}
+
+			bool end_array() {
+				if (_stack.empty()) {
+					_inTopLevelArray = false;
+					return true;
+				}
+				return close();
+			}
+
+			bool key(string_t & val) {
+				_key = std::move(val);
+				return true;
+			}
+
+			bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) {
+				return false;
+			}
+
+		private:
+			bool add(putils::json && val) {
+				_startedTopLevel = true;
+
+				if (_stack.empty()) {
+					_onElement(std::move(val));
+					return true;
+				}
+
+				auto & parent = *_stack.back();
+				if (parent.is_object())
+					parent[_key] = std::move(val);
+				else
+					parent.push_back(std::move(val));
+				return true;
+			}
+
+			bool open(putils::json && val) {
+				_startedTopLevel = true;
+
+				if (_stack.empty()) {
+					_element = std::move(val);
+					_stack.push_back(&_element);
+					return true;
+				}
+
+				// Pointers to the parent chain stay valid: a parent array only grows once its last child is closed
+				auto & parent = *_stack.back();
+				if (parent.is_object())
+					_stack.push_back(&(parent[_key] = std::move(val)));
+				else {
+					parent.push_back(std::move(val));
+					_stack.push_back(&parent.back());
+				}
+				return true;
+			}
+
+			bool close() {
+				_stack.pop_back();
+				if (_stack.empty()) {
+					_onElement(std::move(_element));
+					_element = nullptr;
+				}
+				return true;
+			}
+
+		private:
+			const ElementCallback & _onElement;
+			putils::json _element;
+			std::vector<putils::json *> _stack;
+			string_t _key;
+			bool _startedTopLevel = false;
+			bool _inTopLevelArray = false;
+		};
+
+		// Forwards reads to another streambuf, reporting progress on each refill
+		class ProgressStreamBuf : public std::streambuf {
+		public:
+			ProgressStreamBuf(std::streambuf & source, const ProgressCallback & onProgress) noexcept
+				: _source(source), _onProgress(onProgress)
+			{}
+
+		protected:
+			int_type underflow() override {
+				if (gptr() < egptr())
+					return traits_type::to_int_type(*gptr());
+
+				if (!_onProgress(_bytesRead))
+					return traits_type::eof();
+
+				const auto count = _source.sgetn(_buffer, sizeof(_buffer));
+				if (count <= 0)
+					return traits_type::eof();
+
+				_bytesRead += (size_t)count;
+				setg(_buffer, _buffer, _buffer + count);
+				return traits_type::to_int_type(*gptr());
+			}
+
+		private:
+			std::streambuf & _source;
+			const ProgressCallback & _onProgress;
+			size_t _bytesRead = 0;
+			char _buffer[64 * 1024];
+		};
+	}
+
+	bool forEachElement(std::istream & stream, const ElementCallback & onElement, const ProgressCallback & onProgress) noexcept {
+		ElementBuilder builder(onElement);
+
+		if (onProgress == nullptr)
+			return putils::json::sax_parse(stream, &builder);
+
+		ProgressStreamBuf buf(*stream.rdbuf(), onProgress);
+		std::istream progressStream(&buf);
+		return putils::json::sax_parse(progressStream, &builder);
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <istream>
+#include <functional>
+#include "json.hpp"
+
+namespace jsonStreamHelper {
+	using ElementCallback = std::function<void(putils::json && element)>;
+	// Called with the number of bytes consumed so far. Returning false aborts the parse
+	using ProgressCallback = std::function<bool(size_t bytesRead)>;
+
+	// Parses `stream` without building the whole document: each element of a top-level array is passed to
+	// `onElement` as soon as it is complete. Any other top-level value is passed as a single element.
+	// Returns false if the stream isn't valid JSON or `onProgress` aborted the parse
+	bool forEachElement(std::istream & stream, const ElementCallback & onElement, const ProgressCallback & onProgress = nullptr) noexcept;
+}
@@ -0,0 +1,135 @@
+#include "kmodelHelper.hpp"
+
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include "file_extension.hpp"
+
+namespace kmodelHelper {
+	static constexpr char MAGIC[4] = { 'K', 'M', 'D', 'L' };
+	static constexpr std::uint32_t VERSION = 1;
+
+	struct Header {
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t payloadSize;
+	};
+
+	bool isKModel(std::string_view path) noexcept {
+		return putils::file_extension(path) == EXTENSION;
+	}
+
+	bool write(std::ostream & f, const putils::json & model) noexcept {
+		std::vector<std::uint8_t> payload;
+		putils::json::to_msgpack(model, payload);
+		return writePayload(f, payload);
+	}
+
+	bool writePayload(std::ostream & f, const std::vector<std::uint8_t> & payload) noexcept {
+		Header header;
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.payloadSize = payload.size();
+
+		f.write((const char *)&header, sizeof(header));
+		f.write((const char *)payload.data(), payload.size());
+		return (bool)f;
+	}
+
+	namespace {
+		// Read-only view of a whole file, unmapped on destruction
+		class MappedFile {
+		public:
+			MappedFile(const char * path) noexcept {
+#ifdef _WIN32
+				_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (_file == INVALID_HANDLE_VALUE)
+					return;
+
+				LARGE_INTEGER size;
+				if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+					return;
+
+				_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (_mapping == nullptr)
+					return;
+
+				_data = (const std::uint8_t *)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+				if (_data != nullptr)
+					_size = (size_t)size.QuadPart;
+#else
+				const auto fd = open(path, O_RDONLY);
+				if (fd < 0)
+					return;
+
+				struct stat st;
+				if (fstat(fd, &st) == 0 && st.st_size > 0) {
+					const auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (data != MAP_FAILED) {
+						_data = (const std::uint8_t *)data;
+						_size = (size_t)st.st_size;
+					}
+				}
+				close(fd);
+#endif
+			}
+
+			~MappedFile() noexcept {
+#ifdef _WIN32
+				if (_data != nullptr)
+					UnmapViewOfFile(_data);
+				if (_mapping != nullptr)
+					CloseHandle(_mapping);
+				if (_file != INVALID_HANDLE_VALUE)
+					CloseHandle(_file);
+#else
+				if (_data != nullptr)
+					munmap((void *)_data, _size);
+#endif
+			}
+
+			MappedFile(const MappedFile &) = delete;
+			MappedFile & operator=(const MappedFile &) = delete;
+
+			const std::uint8_t * data() const noexcept { return _data; }
+			size_t size() const noexcept { return _size; }
+
+		private:
+#ifdef _WIN32
+			HANDLE _file = INVALID_HANDLE_VALUE;
+			HANDLE _mapping = nullptr;
+#endif
+			const std::uint8_t * _data = nullptr;
+			size_t _size = 0;
+		};
+	}
+
+	std::optional<putils::json> read(const char * path) noexcept {
+		const MappedFile file(path);
+		if (file.data() == nullptr || file.size() < sizeof(Header))
+			return std::nullopt;
+
+		Header header;
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+			return std::nullopt;
+
+		if (header.payloadSize > file.size() - sizeof(Header))
+			return std::nullopt;
+
+		const auto payload = file.data() + sizeof(Header);
+		auto ret = putils::json::from_msgpack(payload, payload + header.payloadSize, true, false);
+		if (ret.is_discarded())
+			return std::nullopt;
+		return ret;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "json.hpp"
+
+// Binary model format: a small header followed by the MessagePack encoding of the JSON description produced
+// by meta::SaveToJSON, so it round-trips with .json models. It is only a container for that description: reading
+// decodes it into a putils::json DOM, which is instantiated through meta::LoadFromJSON like a .json model.
+// What it saves is the text tokenizing, not the DOM construction or the JSON-based instantiation
+namespace kmodelHelper {
+	static constexpr auto EXTENSION = "kmodel";
+
+	bool isKModel(std::string_view path) noexcept;
+
+	bool write(std::ostream & f, const putils::json & model) noexcept;
+	// `payload` is the MessagePack encoding of the model
+	bool writePayload(std::ostream & f, const std::vector<std::uint8_t> & payload) noexcept;
+	std::optional<putils::json> read(const char * path) noexcept;
+}
@@ -0,0 +1,341 @@
+#include "modelFileHelper.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "meta/Has.hpp"
+#include "meta/SaveToJSON.hpp"
+#include "meta/ToSave.hpp"
+
+#include "helpers/sortHelper.hpp"
+
+#include "jsonStreamHelper.hpp"
+#include "kmodelHelper.hpp"
+
+#include "file_extension.hpp"
+
+namespace modelFileHelper {
+	bool isModelDescription(std::string_view path) noexcept {
+		return putils::file_extension(path) == "json" || kmodelHelper::isKModel(path);
+	}
+
+	std::optional<putils::json> readDescription(const char * path, const ProgressCallback & onProgress) noexcept {
+		if (kmodelHelper::isKModel(path)) {
+			auto ret = kmodelHelper::read(path);
+			if (onProgress != nullptr)
+				onProgress(1.f);
+			return ret;
+		}
+
+		std::ifstream f(path, std::ifstream::binary);
+		if (!f)
+			return std::nullopt;
+
+		std::error_code error;
+		const auto size = std::filesystem::file_size(path, error);
+
+		// Streams the file through the parser rather than reading it whole first
+		std::optional<putils::json> ret;
+		const bool parsed = jsonStreamHelper::forEachElement(f,
+			[&](putils::json && element) noexcept {
+				ret = std::move(element);
+			},
+			[&](size_t bytesRead) noexcept {
+				if (onProgress == nullptr)
+					return true;
+				return onProgress(!error && size > 0 ? (float)bytesRead / (float)size : 0.f);
+			}
+		);
+
+		if (!parsed)
+			return std::nullopt;
+		return ret;
+	}
+
+	// Writes to a temporary file first, so that an interrupted save never leaves a truncated model behind
+	static bool writeAtomically(const char * path, std::ios::openmode mode, const std::function<bool(std::ostream &)> & write) noexcept {
+		std::filesystem::path tmp = path;
+		tmp += ".tmp";
+
+		std::error_code error;
+		{
+			std::ofstream f(tmp, mode | std::ofstream::trunc);
+			if (!f)
+				return false;
+
+			if (!write(f) || !f.flush()) {
+				f.close();
+				std::filesystem::remove(tmp, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tmp, path, error);
+		if (error) {
+			std::filesystem::remove(tmp, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool writeDescription(const char * path, const putils::json & model) noexcept {
+		if (kmodelHelper::isKModel(path))
+			return writeAtomically(path, std::ofstream::binary, [&](std::ostream & f) noexcept {
+				return kmodelHelper::write(f, model);
+			});
+
+		return writeAtomically(path, std::ofstream::out, [&](std::ostream & f) noexcept {
+			f << model.dump(4);
+			return (bool)f;
+		});
+	}
+
+	namespace {
+		// Iterations shared by the thread pool and the calling thread. Tasks which only start once all iterations
+		// have been taken don't call `body`, so the caller doesn't wait for them and may let `body` reference its locals
+		struct ParallelLoop {
+			ParallelLoop(size_t count, std::function<void(size_t)> && body) noexcept
+				: count(count), body(std::move(body))
+			{}
+
+			size_t count;
+			std::function<void(size_t)> body;
+
+			std::atomic<size_t> next = 0;
+			std::atomic<size_t> done = 0;
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+	}
+
+	static void runIterations(ParallelLoop & loop) noexcept {
+		for (auto i = loop.next++; i < loop.count; i = loop.next++) {
+			loop.body(i);
+			if (++loop.done == loop.count) {
+				const std::lock_guard lock(loop.mutex);
+				loop.finished.notify_all();
+			}
+		}
+	}
+
+	// Calls `body` for each index in [0, count) on the thread pool and the calling thread, and returns once all calls are done.
+	// Safe to call from a thread pool task, as the calling thread runs any iteration the pool doesn't get to
+	static void parallelFor(size_t count, std::function<void(size_t)> && body) noexcept {
+		if (count == 0)
+			return;
+
+		const auto loop = std::make_shared<ParallelLoop>(count, std::move(body));
+
+		const auto threads = std::max(std::thread::hardware_concurrency(), 1u);
+		const auto tasks = std::min<size_t>(count, threads) - 1;
+		for (size_t i = 0; i < tasks; ++i)
+			kengine::threadPool().runTask([loop]() noexcept {
+				runIterations(*loop);
+			});
+
+		// Also work on the calling thread, so that a busy thread pool doesn't delay the save
+		runIterations(*loop);
+
+		std::unique_lock lock(loop->mutex);
+		loop->finished.wait(lock, [&] { return loop->done == loop->count; });
+	}
+
+	namespace {
+		struct SavedType {
+			kengine::EntityID id;
+			std::string name;
+		};
+	}
+
+	// Types tagged with meta::ToSave, sorted by name. They are only sorted again when types get tagged or untagged, e.g. by loading a plugin
+	static const std::vector<SavedType> & getSavedTypes() noexcept {
+		static std::vector<SavedType> types;
+		static size_t taggedCount = 0;
+
+		size_t count = 0;
+		for (const auto & [type, toSave] : kengine::entities.with<::meta::ToSave>())
+			++count;
+		if (count == taggedCount)
+			return types;
+		taggedCount = count;
+
+		types.clear();
+		const auto sorted = kengine::sortHelper::getNameSortedEntities<KENGINE_COMPONENT_COUNT,
+			kengine::meta::Has, kengine::meta::SaveToJSON, ::meta::ToSave
+		>();
+		for (const auto & [type, name, has, save, toSave] : sorted)
+			types.push_back({ type.id, name->name.c_str() });
+		return types;
+	}
+
+	// Calls `func(type, save, toSave)` for each saved type of which `e` has a component, in name order
+	template<typename Func>
+	static void forEachSavedComponent(const kengine::Entity & e, Func && func) noexcept {
+		for (const auto & saved : getSavedTypes()) {
+			const auto type = kengine::entities[saved.id];
+			const auto has = type.tryGet<kengine::meta::Has>();
+			const auto save = type.tryGet<kengine::meta::SaveToJSON>();
+			const auto toSave = type.tryGet<::meta::ToSave>();
+			if (has != nullptr && save != nullptr && toSave != nullptr && has->call(e))
+				func(saved, *save, *toSave);
+		}
+	}
+
+	putils::json saveToJSON(const kengine::Entity & e) noexcept {
+		putils::json ret;
+
+		std::vector<const char *> names;
+		std::vector<const kengine::meta::SaveToJSON *> functions;
+		forEachSavedComponent(e, [&](const SavedType & type, const kengine::meta::SaveToJSON & save, const ::meta::ToSave &) noexcept {
+			names.push_back(type.name.c_str());
+			functions.push_back(&save);
+		});
+
+		std::vector<putils::json> values(functions.size());
+		parallelFor(functions.size(), [&](size_t i) noexcept {
+			values[i] = functions[i]->call(e);
+		});
+		for (size_t i = 0; i < names.size(); ++i)
+			ret[names[i]] = std::move(values[i]);
+
+		return ret;
+	}
+
+	SaveSnapshot takeSnapshot(const SaveCache & cache, const kengine::Entity & e) noexcept {
+		SaveSnapshot ret;
+
+		forEachSavedComponent(e, [&](const SavedType & type, const kengine::meta::SaveToJSON & save, const ::meta::ToSave & toSave) noexcept {
+			auto & component = ret.components.emplace_back();
+			component.name = type.name;
+
+			const auto cached = cache.components.find(type.name);
+			if (cached != cache.components.end())
+				component.cached = cached->second;
+
+			if (toSave.snapshot != nullptr)
+				component.serialize = toSave.snapshot(e);
+			else
+				component.serialize = [value = save.call(e)]() noexcept { return value; };
+		});
+
+		return ret;
+	}
+
+	SaveCache serialize(SaveSnapshot && snapshot, const PostProcess & postProcess) noexcept {
+		// Each component is serialized and compared to the cache independently, the cache is then filled in snapshot order
+		std::vector<std::shared_ptr<const SaveCache::Component>> serialized(snapshot.components.size());
+		parallelFor(snapshot.components.size(), [&](size_t i) noexcept {
+			auto & component = snapshot.components[i];
+
+			auto value = component.serialize();
+			if (postProcess != nullptr)
+				postProcess(component.name.c_str(), value);
+
+			// Keeps the cached component, and with it its encoded text and msgpack
+			if (component.cached != nullptr && component.cached->value == value) {
+				serialized[i] = std::move(component.cached);
+				return;
+			}
+
+			const auto ret = std::make_shared<SaveCache::Component>();
+			ret->value = std::move(value);
+			serialized[i] = ret;
+		});
+
+		SaveCache ret;
+		for (size_t i = 0; i < serialized.size(); ++i)
+			ret.components.emplace(std::move(snapshot.components[i].name), std::move(serialized[i]));
+		return ret;
+	}
+
+	bool isModified(const SaveCache & previous, const SaveCache & current) noexcept {
+		if (previous.components.size() != current.components.size())
+			return true;
+
+		// Both maps are sorted by name, and unmodified components are shared
+		return !std::equal(previous.components.begin(), previous.components.end(), current.components.begin(),
+			[](const auto & lhs, const auto & rhs) noexcept {
+				return lhs.first == rhs.first && lhs.second == rhs.second;
+			}
+		);
+	}
+
+	// Indents the component's dump as if it was nested in the model's object
+	static void encodeText(const std::string & name, const SaveCache::Component & component) noexcept {
+		static constexpr auto INDENT = 4;
+
+		const auto value = component.value.dump(INDENT);
+
+		auto & text = component.text;
+		text = std::string(INDENT, ' ') + putils::json(name).dump() + ": ";
+		for (const auto c : value) {
+			text += c;
+			if (c == '\n')
+				text.append(INDENT, ' ');
+		}
+	}
+
+	static void encodeMsgpack(const std::string & name, const SaveCache::Component & component) noexcept {
+		auto & bytes = component.msgpack;
+		bytes = putils::json::to_msgpack(putils::json(name));
+		const auto value = putils::json::to_msgpack(component.value);
+		bytes.insert(bytes.end(), value.begin(), value.end());
+	}
+
+	// Same encoding as putils::json::to_msgpack for an object of `size` elements
+	static void writeMsgpackMapHeader(std::vector<std::uint8_t> & bytes, size_t size) noexcept {
+		if (size <= 15)
+			bytes.push_back(std::uint8_t(0x80 | size));
+		else if (size <= 0xffff) {
+			bytes.push_back(0xde);
+			for (int shift = 8; shift >= 0; shift -= 8)
+				bytes.push_back(std::uint8_t(size >> shift));
+		}
+		else {
+			bytes.push_back(0xdf);
+			for (int shift = 24; shift >= 0; shift -= 8)
+				bytes.push_back(std::uint8_t(size >> shift));
+		}
+	}
+
+	bool writeDescription(const char * path, const SaveCache & cache) noexcept {
+		// A model without any saved component is written as `null`, like an empty putils::json
+		if (cache.components.empty())
+			return writeDescription(path, putils::json{});
+
+		if (kmodelHelper::isKModel(path)) {
+			std::vector<std::uint8_t> payload;
+			writeMsgpackMapHeader(payload, cache.components.size());
+			for (const auto & [name, component] : cache.components) {
+				std::call_once(component->msgpackEncoded, [&] { encodeMsgpack(name, *component); });
+				payload.insert(payload.end(), component->msgpack.begin(), component->msgpack.end());
+			}
+
+			return writeAtomically(path, std::ofstream::binary, [&](std::ostream & f) noexcept {
+				return kmodelHelper::writePayload(f, payload);
+			});
+		}
+
+		std::string text = "{\n";
+		bool first = true;
+		for (const auto & [name, component] : cache.components) {
+			std::call_once(component->textEncoded, [&] { encodeText(name, *component); });
+			if (!first)
+				text += ",\n";
+			text += component->text;
+			first = false;
+		}
+		text += "\n}";
+
+		return writeAtomically(path, std::ofstream::out, [&](std::ostream & f) noexcept {
+			f << text;
+			return (bool)f;
+		});
+	}
+}
\ No newline at end of file
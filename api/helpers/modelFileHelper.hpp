@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <vector>
+#include "kengine.hpp"
+#include "json.hpp"
+#include "meta/ToSave.hpp"
+
+// Reading and writing of model descriptions, shared by the model loader and the model converter
+namespace modelFileHelper {
+	// .json and .kmodel files describe a model entity, other formats are imported through GraphicsComponent
+	bool isModelDescription(std::string_view path) noexcept;
+
+	// Called with the proportion of the file read so far. Returning false aborts
+	using ProgressCallback = std::function<bool(float progress)>;
+
+	// Safe to call from any thread
+	std::optional<putils::json> readDescription(const char * path, const ProgressCallback & onProgress = nullptr) noexcept;
+	// Picks the format from the extension. The file is replaced atomically
+	bool writeDescription(const char * path, const putils::json & model) noexcept;
+
+	// Serializes the components of `e` whose type is tagged with meta::ToSave. Must be called on the main thread
+	putils::json saveToJSON(const kengine::Entity & e) noexcept;
+
+	// Serialized components of a model, kept between saves so that unmodified components aren't encoded again.
+	// Components are immutable once cached, so a copy of the cache is a cheap snapshot that can be written from another thread
+	struct SaveCache {
+		struct Component {
+			putils::json value;
+
+			// Lazily encoded by the first thread writing the component
+			mutable std::string text; // As it appears in the output of `dump(4)`
+			mutable std::vector<std::uint8_t> msgpack; // Name and value
+			mutable std::once_flag textEncoded;
+			mutable std::once_flag msgpackEncoded;
+		};
+
+		std::map<std::string, std::shared_ptr<const Component>> components; // Sorted like the keys of a putils::json object
+	};
+
+	// Copies of the components of a model, waiting to be serialized
+	struct SaveSnapshot {
+		struct Component {
+			std::string name;
+			::meta::ToSave::Serializer serialize;
+			std::shared_ptr<const SaveCache::Component> cached; // Reused if the component still serializes to the same value
+		};
+
+		std::vector<Component> components;
+	};
+
+	// Called on each newly serialized component before it is compared to the cache. May be called from several threads at once
+	using PostProcess = std::function<void(const char * type, putils::json & value)>;
+
+	// Must be called on the main thread, copies every saved component: components may be modified by any plugin or script,
+	// so they're compared to the cache once serialized rather than trusted to be marked dirty
+	SaveSnapshot takeSnapshot(const SaveCache & cache, const kengine::Entity & e) noexcept;
+	// Safe to call from any thread, serializes the components on the thread pool. Returns the updated cache, in which unmodified components
+	// are shared with the previous one
+	SaveCache serialize(SaveSnapshot && snapshot, const PostProcess & postProcess = nullptr) noexcept;
+	// Returns whether components were added, removed or modified between `previous` and the cache `serialize` made from it
+	bool isModified(const SaveCache & previous, const SaveCache & current) noexcept;
+	// Produces the same file as `writeDescription` for the JSON object holding the cached components
+	bool writeDescription(const char * path, const SaveCache & cache) noexcept;
+}
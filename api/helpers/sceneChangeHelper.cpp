@@ -0,0 +1,78 @@
+#include "sceneChangeHelper.hpp"
+
+#include "data/AnimationComponent.hpp"
+#include "data/CameraComponent.hpp"
+#include "data/TransformGenerationComponent.hpp"
+#include "data/ViewportComponent.hpp"
+#include "functions/IsBusy.hpp"
+
+#include "helpers/typeHelper.hpp"
+
+#include "hashHelper.hpp"
+
+#include "imgui.h"
+
+namespace sceneChangeHelper {
+	using namespace kengine;
+
+	static void hashCamera(std::uint64_t & hash, const Entity & e, const CameraComponent & cam) noexcept {
+		hashHelper::hashBytes(hash, &e.id, sizeof(e.id));
+		hashHelper::hashBytes(hash, &cam.frustum, sizeof(cam.frustum));
+		hashHelper::hashBytes(hash, &cam.yaw, sizeof(cam.yaw));
+		hashHelper::hashBytes(hash, &cam.pitch, sizeof(cam.pitch));
+		hashHelper::hashBytes(hash, &cam.roll, sizeof(cam.roll));
+		if (const auto viewport = e.tryGet<ViewportComponent>())
+			hashHelper::hashBytes(hash, &viewport->boundingBox, sizeof(viewport->boundingBox));
+	}
+
+	std::uint64_t getCameraHash(EntityID camera) noexcept {
+		std::uint64_t ret = hashHelper::FNV_OFFSET;
+
+		if (camera != INVALID_ID) {
+			const auto e = entities[camera];
+			if (const auto cam = e.tryGet<CameraComponent>())
+				hashCamera(ret, e, *cam);
+		}
+		else
+			for (const auto & [e, cam] : entities.with<CameraComponent>())
+				hashCamera(ret, e, cam);
+
+		const auto & displaySize = ImGui::GetIO().DisplaySize;
+		hashHelper::hashBytes(ret, &displaySize, sizeof(displaySize));
+		return ret;
+	}
+
+	bool isBusy() noexcept {
+		for (const auto & [e, isBusy] : entities.with<::functions::IsBusy>())
+			if (isBusy())
+				return true;
+
+		for (const auto & [e, animation] : entities.with<AnimationComponent>())
+			if (animation.speed != 0.f)
+				return true;
+
+		return false;
+	}
+
+	// Kept in the entity pools rather than in a static, as each plugin links its own copy of the api
+	static TransformGenerationComponent & getTransformGenerationComponent() noexcept {
+		return typeHelper::getTypeEntity<TransformComponent>().attach<TransformGenerationComponent>();
+	}
+
+	std::uint64_t getTransformGeneration() noexcept {
+		return getTransformGenerationComponent().generation;
+	}
+
+	void markTransformsChanged() noexcept {
+		++getTransformGenerationComponent().generation;
+	}
+
+	bool sameTransform(const TransformComponent & lhs, const TransformComponent & rhs) noexcept {
+		const auto samePoint = [](const putils::Point3f & a, const putils::Point3f & b) noexcept {
+			return a.x == b.x && a.y == b.y && a.z == b.z;
+		};
+		return samePoint(lhs.boundingBox.position, rhs.boundingBox.position) &&
+			samePoint(lhs.boundingBox.size, rhs.boundingBox.size) &&
+			lhs.yaw == rhs.yaw && lhs.pitch == rhs.pitch && lhs.roll == rhs.roll;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include "kengine.hpp"
+#include "data/TransformComponent.hpp"
+
+// Signatures compared from one frame to the next by systems that cache what they compute from the scene.
+// Components modified by editors are noticed through dirtyHelper::getGeneration
+namespace sceneChangeHelper {
+	// Hash of the display size and of `camera`'s frustum, orientation and viewport. All cameras are hashed if `camera` is INVALID_ID
+	std::uint64_t getCameraHash(kengine::EntityID camera = kengine::INVALID_ID) noexcept;
+
+	// Whether a system reports work in progress through functions::IsBusy (e.g. loading or removing entities) or an animation is playing
+	bool isBusy() noexcept;
+
+	// Changes whenever a model instance moved, appeared or was removed, whatever moved it (editors, physics, scripts...).
+	// Only maintained while the picking plugin is loaded, as it already compares the transforms of instances each frame
+	std::uint64_t getTransformGeneration() noexcept;
+	void markTransformsChanged() noexcept;
+
+	// Exact comparison, used to only recompute what depends on transforms that were modified since they were cached
+	bool sameTransform(const kengine::TransformComponent & lhs, const kengine::TransformComponent & rhs) noexcept;
+}
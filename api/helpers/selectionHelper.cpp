@@ -0,0 +1,34 @@
+#include "selectionHelper.hpp"
+
+#include "data/SelectedComponent.hpp"
+#include "functions/OnSelectionChanged.hpp"
+
+namespace selectionHelper {
+	using namespace kengine;
+
+	static void notify(EntityID id, bool selected) noexcept {
+		for (const auto & [e, onSelectionChanged] : entities.with<::functions::OnSelectionChanged>())
+			onSelectionChanged(id, selected);
+	}
+
+	void select(Entity & e) noexcept {
+		if (e.has<SelectedComponent>())
+			return;
+		e += SelectedComponent{};
+		notify(e.id, true);
+	}
+
+	void deselect(Entity & e) noexcept {
+		if (!e.has<SelectedComponent>())
+			return;
+		e.detach<SelectedComponent>();
+		notify(e.id, false);
+	}
+
+	void toggle(Entity & e) noexcept {
+		if (e.has<SelectedComponent>())
+			deselect(e);
+		else
+			select(e);
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "kengine.hpp"
+
+// Attach or detach SelectedComponent and notify the OnSelectionChanged functions, so that systems
+// tracking the selection only process the entities that changed.
+// SelectedComponents modified directly (e.g. by kengine's own tools) aren't notified: systems that must follow them
+// have to notice the selection changed themselves, as the highlight system does by comparing a signature of it
+namespace selectionHelper {
+	void select(kengine::Entity & e) noexcept;
+	void deselect(kengine::Entity & e) noexcept;
+	void toggle(kengine::Entity & e) noexcept;
+}
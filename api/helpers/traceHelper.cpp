@@ -0,0 +1,68 @@
+#include "traceHelper.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include "json.hpp"
+
+namespace traceHelper {
+	bool write(const char * path, const std::vector<Event> & events) noexcept {
+		putils::json traceEvents = putils::json::array();
+		for (const auto & event : events)
+			traceEvents.push_back({
+				{ "name", event.name },
+				{ "cat", event.category },
+				{ "ph", "X" }, // Complete event, with a duration
+				{ "ts", event.startMicroseconds },
+				{ "dur", event.durationMicroseconds },
+				{ "pid", 0 },
+				{ "tid", event.threadId }
+			});
+
+		std::ofstream f(path);
+		if (!f)
+			return false;
+
+		f << putils::json{ { "traceEvents", std::move(traceEvents) }, { "displayTimeUnit", "ms" } }.dump();
+		return (bool)f;
+	}
+
+	void writeSummary(std::ostream & out, std::vector<Event> events, size_t count, const char * excludedCategory) noexcept {
+		if (excludedCategory != nullptr)
+			events.erase(std::remove_if(events.begin(), events.end(), [&](const Event & event) noexcept {
+				return event.category == excludedCategory;
+			}), events.end());
+
+		count = std::min(count, events.size());
+		std::partial_sort(events.begin(), events.begin() + count, events.end(), [](const Event & lhs, const Event & rhs) noexcept {
+			return lhs.durationMicroseconds > rhs.durationMicroseconds;
+		});
+
+		for (size_t i = 0; i < count; ++i) {
+			const auto & event = events[i];
+			out << std::setw(10) << std::fixed << std::setprecision(3) << event.durationMicroseconds / 1000.0 << " ms  "
+				<< event.category << ": " << event.name << '\n';
+		}
+		out << std::flush;
+	}
+
+	void Recorder::add(std::string name, std::string category, Clock::time_point start, Clock::time_point end) noexcept {
+		const auto toMicroseconds = [](Clock::duration duration) noexcept {
+			return std::chrono::duration<double, std::micro>(duration).count();
+		};
+
+		const std::lock_guard lock(_mutex);
+
+		const auto thread = std::find(_threads.begin(), _threads.end(), std::this_thread::get_id());
+		const auto threadId = (size_t)(thread - _threads.begin());
+		if (thread == _threads.end())
+			_threads.push_back(std::this_thread::get_id());
+
+		_events.push_back({ std::move(name), std::move(category), toMicroseconds(start - _origin), toMicroseconds(end - start), threadId });
+	}
+
+	std::vector<Event> Recorder::getEvents() const noexcept {
+		const std::lock_guard lock(_mutex);
+		return _events;
+	}
+}
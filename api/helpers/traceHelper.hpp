@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes events in the Trace Event format read by chrome://tracing and Perfetto
+namespace traceHelper {
+	struct Event {
+		std::string name;
+		std::string category;
+		double startMicroseconds;
+		double durationMicroseconds;
+		size_t threadId = 0;
+	};
+
+	bool write(const char * path, const std::vector<Event> & events) noexcept;
+	// Prints the `count` longest events, leaving out those of `excludedCategory`
+	void writeSummary(std::ostream & out, std::vector<Event> events, size_t count, const char * excludedCategory = nullptr) noexcept;
+
+	// Collects events from any thread, timed from the recorder's creation
+	class Recorder {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		template<typename Func>
+		void measure(std::string name, std::string category, Func && func) noexcept {
+			const auto start = Clock::now();
+			func();
+			add(std::move(name), std::move(category), start, Clock::now());
+		}
+
+		void add(std::string name, std::string category, Clock::time_point start, Clock::time_point end) noexcept;
+		std::vector<Event> getEvents() const noexcept;
+
+	private:
+		const Clock::time_point _origin = Clock::now();
+		mutable std::mutex _mutex;
+		std::vector<Event> _events;
+		std::vector<std::thread::id> _threads; // Indices are used as thread ids in the trace
+	};
+}
@@ -0,0 +1,200 @@
+#include "undoHelper.hpp"
+
+#include <algorithm>
+
+#include "data/ModelColliderComponent.hpp"
+#include "data/TransformComponent.hpp"
+#include "data/UndoTargetComponent.hpp"
+
+#include "dirtyHelper.hpp"
+
+namespace undoHelper {
+	using namespace kengine;
+
+	using FieldDelta = UndoJournalComponent::FieldDelta;
+	using PendingEdit = UndoJournalComponent::PendingEdit;
+	static constexpr auto FIELD_COUNT = UndoJournalComponent::TRANSFORM_FIELD_COUNT;
+
+	static UndoJournalComponent * getJournal() noexcept {
+		for (auto [e, journal] : entities.with<UndoJournalComponent>())
+			if (journal.capacity > 0)
+				return &journal;
+		return nullptr;
+	}
+
+	static std::uint32_t getGeneration(UndoJournalComponent & journal, EntityID id) noexcept {
+		auto e = entities[id];
+		if (!e.has<UndoTargetComponent>())
+			e += UndoTargetComponent{ journal.nextGeneration++ };
+		return e.get<UndoTargetComponent>().generation;
+	}
+
+	// Returns false if the entity was removed since `generation` was taken, even if its id has been reused
+	static bool isSameEntity(EntityID id, std::uint32_t generation) noexcept {
+		const auto target = entities[id].tryGet<UndoTargetComponent>();
+		return target != nullptr && target->generation == generation;
+	}
+
+	static TransformComponent * getTransform(EntityID id, std::int32_t collider) noexcept {
+		auto e = entities[id];
+		if (collider < 0)
+			return e.tryGet<TransformComponent>();
+
+		const auto modelColliders = e.tryGet<ModelColliderComponent>();
+		if (modelColliders == nullptr || collider >= (std::int32_t)modelColliders->colliders.size())
+			return nullptr;
+		return &modelColliders->colliders[collider].transform;
+	}
+
+	static std::array<float *, FIELD_COUNT> getFields(TransformComponent & transform) noexcept {
+		auto & box = transform.boundingBox;
+		return {
+			&box.position.x, &box.position.y, &box.position.z,
+			&box.size.x, &box.size.y, &box.size.z,
+			&transform.yaw, &transform.pitch, &transform.roll
+		};
+	}
+
+	static void push(UndoJournalComponent & journal, const FieldDelta & delta) noexcept {
+		if (journal.end - journal.begin == journal.capacity) {
+			// Drop the oldest step entirely, so that no partial step is ever replayed
+			do
+				++journal.begin;
+			while (journal.begin != journal.end && !journal.deltas[journal.begin % journal.capacity].stepStart);
+			journal.cursor = std::max(journal.cursor, journal.begin);
+		}
+
+		journal.deltas[journal.end % journal.capacity] = delta;
+		++journal.end;
+	}
+
+	// Records the fields that changed since the edit started as a new step, discarding the steps that could be redone
+	static void commit(UndoJournalComponent & journal, const PendingEdit & edit) noexcept {
+		if (!isSameEntity(edit.entity, edit.generation))
+			return;
+
+		const auto transform = getTransform(edit.entity, edit.collider);
+		if (transform == nullptr)
+			return;
+
+		const auto fields = getFields(*transform);
+		bool stepStart = true;
+		for (size_t i = 0; i < FIELD_COUNT; ++i) {
+			if (*fields[i] == edit.before[i])
+				continue;
+
+			if (stepStart)
+				journal.end = journal.cursor;
+			push(journal, { edit.entity, edit.generation, edit.collider, (std::uint8_t)i, stepStart, edit.before[i], *fields[i] });
+			stepStart = false;
+		}
+
+		journal.cursor = journal.end;
+	}
+
+	void trackGizmo(const TransformTarget & target, bool manipulated) noexcept {
+		const auto journal = getJournal();
+		if (journal == nullptr)
+			return;
+
+		auto & pending = journal->pending;
+		// Edits of removed entities are never committed
+		pending.erase(std::remove_if(pending.begin(), pending.end(), [](const PendingEdit & edit) noexcept {
+			return !isSameEntity(edit.entity, edit.generation);
+		}), pending.end());
+
+		const auto it = std::find_if(pending.begin(), pending.end(), [&](const PendingEdit & edit) noexcept {
+			return edit.entity == target.entity && edit.collider == target.collider;
+		});
+
+		if (manipulated) {
+			if (it != pending.end())
+				return;
+
+			const auto transform = getTransform(target.entity, target.collider);
+			if (transform == nullptr)
+				return;
+
+			PendingEdit edit{ target.entity, getGeneration(*journal, target.entity), target.collider };
+			const auto fields = getFields(*transform);
+			for (size_t i = 0; i < FIELD_COUNT; ++i)
+				edit.before[i] = *fields[i];
+			pending.push_back(edit);
+		}
+		else if (it != pending.end()) {
+			commit(*journal, *it);
+			pending.erase(it);
+		}
+	}
+
+	// `expected` is the value the field had after the delta was applied in the other direction
+	static void apply(const FieldDelta & delta, float value, float expected) noexcept {
+		if (!isSameEntity(delta.entity, delta.generation))
+			return;
+
+		const auto transform = getTransform(delta.entity, delta.collider);
+		if (transform == nullptr)
+			return;
+
+		// Colliders are identified by their index, which refers to another collider once one before it is removed
+		auto & field = *getFields(*transform)[delta.field];
+		if (delta.collider >= 0 && field != expected)
+			return;
+		field = value;
+
+		auto e = entities[delta.entity];
+		if (delta.collider < 0)
+			dirtyHelper::markDirty<TransformComponent>(e);
+		else
+			dirtyHelper::markDirty<ModelColliderComponent>(e);
+	}
+
+	bool canUndo() noexcept {
+		const auto journal = getJournal();
+		return journal != nullptr && journal->cursor > journal->begin;
+	}
+
+	bool canRedo() noexcept {
+		const auto journal = getJournal();
+		return journal != nullptr && journal->cursor < journal->end;
+	}
+
+	void undo() noexcept {
+		if (!canUndo())
+			return;
+
+		auto & journal = *getJournal();
+		auto i = journal.cursor;
+		const FieldDelta * delta;
+		do {
+			--i;
+			delta = &journal.deltas[i % journal.capacity];
+			apply(*delta, delta->before, delta->after);
+		} while (!delta->stepStart && i > journal.begin);
+		journal.cursor = i;
+	}
+
+	void redo() noexcept {
+		if (!canRedo())
+			return;
+
+		auto & journal = *getJournal();
+		auto i = journal.cursor;
+		do {
+			const auto & delta = journal.deltas[i % journal.capacity];
+			apply(delta, delta.after, delta.before);
+			++i;
+		} while (i != journal.end && !journal.deltas[i % journal.capacity].stepStart);
+		journal.cursor = i;
+	}
+
+	void reset(UndoJournalComponent & journal, size_t capacity) noexcept {
+		// A step holds at most one delta per field, it must fit in the buffer
+		journal.capacity = std::max(capacity, FIELD_COUNT);
+		journal.deltas.assign(journal.capacity, FieldDelta{});
+		journal.begin = 0;
+		journal.cursor = 0;
+		journal.end = 0;
+		journal.pending.clear();
+	}
+}
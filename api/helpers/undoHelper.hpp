@@ -0,0 +1,26 @@
+#pragma once
+
+#include "kengine.hpp"
+#include "data/UndoJournalComponent.hpp"
+
+// Transform edits are journaled as per-field deltas in the UndoJournalComponent created by the undo plugin.
+// All functions do nothing when the plugin isn't loaded
+namespace undoHelper {
+	// Identifies either the TransformComponent of `entity` (when `collider` is -1) or the transform of one of its colliders
+	struct TransformTarget {
+		kengine::EntityID entity;
+		std::int32_t collider = -1;
+	};
+
+	// Called each frame after drawing the gizmo of `target`. The transform's state when `manipulated` becomes true
+	// is compared to its state when it becomes false again, so a whole drag is recorded as a single step
+	void trackGizmo(const TransformTarget & target, bool manipulated) noexcept;
+
+	bool canUndo() noexcept;
+	bool canRedo() noexcept;
+	void undo() noexcept;
+	void redo() noexcept;
+
+	// Drops the history and sizes the ring buffer for `capacity` deltas
+	void reset(UndoJournalComponent & journal, size_t capacity) noexcept;
+}
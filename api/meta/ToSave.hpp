@@ -1,5 +1,28 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include "kengine.hpp"
+#include "json.hpp"
+#include "reflection/json_helper.hpp"
+
 namespace meta {
-	struct ToSave {};
+	// Tags the component types saved in model files
+	struct ToSave {
+		using Serializer = std::function<putils::json()>;
+
+		// Copies the component on the main thread, the returned function serializes the copy from any thread.
+		// Types without one are serialized on the main thread through kengine::meta::SaveToJSON
+		std::function<Serializer(const kengine::Entity & e)> snapshot = nullptr;
+	};
+
+	template<typename Comp>
+	ToSave toSave() noexcept {
+		return { [](const kengine::Entity & e) noexcept -> ToSave::Serializer {
+			const auto copy = std::make_shared<const Comp>(e.get<Comp>());
+			return [copy]() noexcept {
+				return putils::reflection::to_json(*copy);
+			};
+		} };
+	}
 }
@@ -7,11 +7,15 @@
 #include "data/AnimationFilesComponent.hpp"
 #include "data/EditorComponent.hpp"
 #include "data/ModelAnimationComponent.hpp"
+#include "data/WatchedFilesComponent.hpp"
 
 #include "functions/Execute.hpp"
+#include "functions/OnTerminate.hpp"
 
 #include "meta/ToSave.hpp"
 
+#include "helpers/adjustableHelper.hpp"
+#include "helpers/dirtyHelper.hpp"
 #include "helpers/instanceHelper.hpp"
 #include "helpers/typeHelper.hpp"
 
@@ -23,20 +27,31 @@ using namespace kengine;
 static bool g_active = true;
 static ImGui::FileBrowser g_dialog;
 
+static EntityID g_id = INVALID_ID;
+static bool g_reloadRequested = false;
+
+// The AssImpSystem only reloads animation files in its editor mode, which is forced on for the frame following a change
+static adjustableHelper::BoolOverride g_editorMode{ "Animation", "Editor mode (reload files each frame)" };
+
 EXPORT void loadKenginePlugin(void * state) noexcept {
 	struct impl {
 		static void init() noexcept {
 			g_dialog.SetTitle("Add an animation file");
 
-			typeHelper::getTypeEntity<AnimationFilesComponent>() += meta::ToSave{};
+			typeHelper::getTypeEntity<AnimationFilesComponent>() += meta::toSave<AnimationFilesComponent>();
 
 			entities += [](Entity & e) noexcept {
+				g_id = e.id;
 				e += EditorComponent{ "Animations", &g_active };
 				e += functions::Execute{ execute };
+				e += functions::OnTerminate{ []() noexcept { g_editorMode.restore(); } };
+				e += WatchedFilesComponent{ .onChange = [](const char * path) noexcept { g_reloadRequested = true; } };
 			};
 		}
 
 		static void execute(float deltaTime) noexcept {
+			watchAnimationFiles();
+
 			if (!g_active)
 				return;
 
@@ -48,7 +63,8 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 						continue;
 
 					auto & animFiles = model.attach<AnimationFilesComponent>();
-					displayAnimFileLoader(animFiles);
+					if (displayAnimFileLoader(animFiles))
+						dirtyHelper::markDirty<AnimationFilesComponent>(model);
 
 					auto & anim = e.attach<AnimationComponent>();
 					displayAnimPicker(anim, *modelAnim);
@@ -58,22 +74,37 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 			ImGui::End();
 		}
 
-		static void displayAnimFileLoader(AnimationFilesComponent & animFiles) noexcept {
+		static void watchAnimationFiles() noexcept {
+			auto & watched = entities[g_id].get<WatchedFilesComponent>();
+			watched.files.clear();
+			for (const auto & [e, animFiles] : entities.with<AnimationFilesComponent>())
+				watched.files.insert(watched.files.end(), animFiles.files.begin(), animFiles.files.end());
+
+			g_editorMode.restore();
+			if (g_reloadRequested) {
+				g_editorMode.set(true);
+				g_reloadRequested = false;
+			}
+		}
+
+		// Returns whether a file was added
+		static bool displayAnimFileLoader(AnimationFilesComponent & animFiles) noexcept {
 			if (ImGui::Button("Add animation file", { -1.f, 0.f }))
 				g_dialog.Open();
 
 			g_dialog.Display();
 			if (!g_dialog.HasSelected())
-				return;
+				return false;
 
 			const auto selected = g_dialog.GetSelected().string();
 			g_dialog.ClearSelected();
 
 			for (const auto & f : animFiles.files)
 				if (f == selected)
-					return;
+					return false;
 			
 			animFiles.files.push_back(std::move(selected));
+			return true;
 		}
 
 		static void displayAnimPicker(AnimationComponent & anim, const ModelAnimationComponent & modelAnim) noexcept {
@@ -0,0 +1,407 @@
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+#include <glm/glm.hpp>
+
+#include "kengine.hpp"
+#include "Export.hpp"
+#include "helpers/pluginHelper.hpp"
+
+#include "data/AdjustableComponent.hpp"
+#include "data/CameraComponent.hpp"
+#include "data/InputComponent.hpp"
+#include "data/InstanceComponent.hpp"
+#include "data/SelectedComponent.hpp"
+#include "data/TransformComponent.hpp"
+#include "data/ViewportComponent.hpp"
+
+#include "functions/Execute.hpp"
+
+#include "helpers/cameraHelper.hpp"
+#include "helpers/matrixHelper.hpp"
+#include "helpers/sceneChangeHelper.hpp"
+#include "helpers/selectionHelper.hpp"
+
+#include "imgui.h"
+
+using namespace kengine;
+
+// Shift + left drag selects the model instances whose screen-space bounds overlap a rectangle,
+// Alt + left drag those whose bounds' center is inside a lasso. Ctrl adds to the current selection instead of replacing it.
+// Bounds are projected once per camera change, and only reprojected for entities whose transform or model's transform changed since,
+// then bucketed in a uniform grid so that resolving a selection only tests the entities in the cells it covers
+
+enum class SelectionMode {
+	None,
+	Box,
+	Lasso
+};
+
+struct ScreenRect {
+	glm::vec2 min;
+	glm::vec2 max;
+};
+
+struct ProjectedEntity {
+	EntityID id;
+	// As of the last projection
+	TransformComponent transform;
+	TransformComponent modelTransform;
+	ScreenRect rect;
+	bool visible = false; // False when behind the camera or off-screen
+	bool seen = false; // Set while refreshing the index, to find removed entities
+};
+
+static struct {
+	std::vector<ProjectedEntity> entities;
+	std::unordered_map<EntityID, size_t> indices;
+
+	std::vector<std::vector<size_t>> cells;
+	int columns = 0;
+	int rows = 0;
+	int cellSize = 0;
+
+	std::uint64_t cameraHash = 0;
+} g_index;
+
+static int g_cellSize = 64; // In pixels
+static float g_lassoPointSpacing = 4.f; // In pixels
+
+static SelectionMode g_mode = SelectionMode::None;
+static bool g_additive = false;
+static EntityID g_window = INVALID_ID;
+static std::vector<glm::vec2> g_points; // Drag start and end for boxes, outline for lassos
+
+EXPORT void loadKenginePlugin(void * state) noexcept {
+	struct impl {
+		static void init() noexcept {
+			entities += [](Entity & e) noexcept {
+				e += functions::Execute{ execute };
+
+				InputComponent input;
+				input.onMouseButton = [](EntityID window, int button, const putils::Point2f & coords, bool pressed) noexcept {
+					if (button != GLFW_MOUSE_BUTTON_LEFT)
+						return;
+					if (pressed)
+						beginDrag(window, coords);
+					else
+						endDrag();
+				};
+				input.onMouseMove = [](EntityID window, const putils::Point2f & coords, const putils::Point2f & rel) noexcept {
+					drag(coords);
+				};
+				e += input;
+
+				e += AdjustableComponent{
+					"Area selection", {
+						{ "Grid cell size (pixels)", &g_cellSize },
+						{ "Lasso point spacing (pixels)", &g_lassoPointSpacing }
+					}
+				};
+			};
+		}
+
+		static void execute(float deltaTime) noexcept {
+			if (g_mode == SelectionMode::None || g_points.size() < 2)
+				return;
+
+			const auto drawList = ImGui::GetForegroundDrawList();
+			const auto color = ImGui::GetColorU32(ImGuiCol_DragDropTarget);
+			if (g_mode == SelectionMode::Box)
+				drawList->AddRect({ g_points[0].x, g_points[0].y }, { g_points[1].x, g_points[1].y }, color);
+			else {
+				std::vector<ImVec2> outline;
+				outline.reserve(g_points.size());
+				for (const auto & point : g_points)
+					outline.push_back({ point.x, point.y });
+				drawList->AddPolyline(outline.data(), (int)outline.size(), color, ImDrawFlags_Closed, 1.f);
+			}
+		}
+
+		static void beginDrag(EntityID window, const putils::Point2f & coords) noexcept {
+			const auto & io = ImGui::GetIO();
+			if (io.WantCaptureMouse)
+				return;
+
+			if (io.KeyShift)
+				g_mode = SelectionMode::Box;
+			else if (io.KeyAlt)
+				g_mode = SelectionMode::Lasso;
+			else
+				return;
+
+			g_additive = io.KeyCtrl;
+			g_window = window;
+			g_points = { { coords.x, coords.y } };
+			if (g_mode == SelectionMode::Box)
+				g_points.push_back(g_points[0]);
+		}
+
+		static void drag(const putils::Point2f & coords) noexcept {
+			const glm::vec2 point{ coords.x, coords.y };
+			if (g_mode == SelectionMode::Box)
+				g_points[1] = point;
+			else if (g_mode == SelectionMode::Lasso && glm::length(point - g_points.back()) >= g_lassoPointSpacing)
+				g_points.push_back(point);
+		}
+
+		static void endDrag() noexcept {
+			if (g_mode == SelectionMode::None)
+				return;
+
+			const auto mode = g_mode;
+			g_mode = SelectionMode::None;
+			if (g_points.size() < 2 || (mode == SelectionMode::Lasso && g_points.size() < 3))
+				return;
+
+			refreshIndex(g_window);
+			const auto selected = mode == SelectionMode::Box ? queryBox() : queryLasso();
+
+			if (!g_additive) {
+				const std::unordered_set<EntityID> selectedSet(selected.begin(), selected.end());
+				std::vector<EntityID> previous;
+				for (const auto & [e, selectedComp] : entities.with<SelectedComponent>())
+					if (!selectedSet.contains(e.id))
+						previous.push_back(e.id);
+				for (const auto id : previous) {
+					auto e = entities[id];
+					selectionHelper::deselect(e);
+				}
+			}
+
+			for (const auto id : selected) {
+				auto e = entities[id];
+				selectionHelper::select(e);
+			}
+		}
+
+		static std::vector<EntityID> queryBox() noexcept {
+			const ScreenRect area{ glm::min(g_points[0], g_points[1]), glm::max(g_points[0], g_points[1]) };
+
+			std::vector<EntityID> ret;
+			for (const auto index : getCandidates(area)) {
+				const auto & projected = g_index.entities[index];
+				const auto & rect = projected.rect;
+				if (rect.min.x <= area.max.x && rect.max.x >= area.min.x && rect.min.y <= area.max.y && rect.max.y >= area.min.y)
+					ret.push_back(projected.id);
+			}
+			return ret;
+		}
+
+		static std::vector<EntityID> queryLasso() noexcept {
+			ScreenRect area{ g_points[0], g_points[0] };
+			for (const auto & point : g_points) {
+				area.min = glm::min(area.min, point);
+				area.max = glm::max(area.max, point);
+			}
+
+			std::vector<EntityID> ret;
+			for (const auto index : getCandidates(area)) {
+				const auto & projected = g_index.entities[index];
+				if (isInLasso((projected.rect.min + projected.rect.max) * .5f))
+					ret.push_back(projected.id);
+			}
+			return ret;
+		}
+
+		// Even-odd rule
+		static bool isInLasso(const glm::vec2 & point) noexcept {
+			bool inside = false;
+			for (size_t i = 0, j = g_points.size() - 1; i < g_points.size(); j = i++) {
+				const auto & a = g_points[i];
+				const auto & b = g_points[j];
+				if ((a.y > point.y) != (b.y > point.y) && point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+					inside = !inside;
+			}
+			return inside;
+		}
+
+		// Returns the indices of the visible entities stored in the cells covered by `area`
+		static std::vector<size_t> getCandidates(const ScreenRect & area) noexcept {
+			std::vector<size_t> ret;
+			if (g_index.cells.empty())
+				return ret;
+
+			const auto minCell = getCell(area.min);
+			const auto maxCell = getCell(area.max);
+
+			// Entities spanning several cells are stored in each of them
+			std::vector<bool> visited(g_index.entities.size(), false);
+			for (int y = minCell.y; y <= maxCell.y; ++y)
+				for (int x = minCell.x; x <= maxCell.x; ++x)
+					for (const auto index : g_index.cells[y * g_index.columns + x]) {
+						if (visited[index])
+							continue;
+						visited[index] = true;
+						ret.push_back(index);
+					}
+			return ret;
+		}
+
+		static glm::ivec2 getCell(const glm::vec2 & point) noexcept {
+			return {
+				std::clamp((int)(point.x / (float)g_index.cellSize), 0, g_index.columns - 1),
+				std::clamp((int)(point.y / (float)g_index.cellSize), 0, g_index.rows - 1)
+			};
+		}
+
+		static void refreshIndex(EntityID window) noexcept {
+			const auto camera = getCamera(window);
+			if (camera == INVALID_ID) {
+				g_index.cells.clear();
+				return;
+			}
+
+			const auto cameraEntity = entities[camera];
+			const auto & cam = cameraEntity.get<CameraComponent>();
+			const auto & viewport = cameraEntity.get<ViewportComponent>();
+			const auto & displaySize = ImGui::GetIO().DisplaySize;
+
+			const auto cameraHash = sceneChangeHelper::getCameraHash(camera);
+			const bool cameraChanged = cameraHash != g_index.cameraHash;
+			g_index.cameraHash = cameraHash;
+
+			const auto viewProj = matrixHelper::getProjMatrix(cam, viewport, 0.001f, 1000.f) * matrixHelper::getViewMatrix(cam, viewport);
+			const glm::vec2 viewportPos{ viewport.boundingBox.position.x * displaySize.x, viewport.boundingBox.position.y * displaySize.y };
+			const glm::vec2 viewportSize{ viewport.boundingBox.size.x * displaySize.x, viewport.boundingBox.size.y * displaySize.y };
+
+			bool changed = cameraChanged;
+			for (auto & projected : g_index.entities)
+				projected.seen = false;
+
+			static const TransformComponent identity;
+			for (const auto & [e, transform, instance] : entities.with<TransformComponent, InstanceComponent>()) {
+				const auto modelTransform = entities[instance.model].tryGet<TransformComponent>();
+				const auto & model = modelTransform != nullptr ? *modelTransform : identity;
+
+				auto it = g_index.indices.find(e.id);
+				if (it == g_index.indices.end()) {
+					it = g_index.indices.emplace(e.id, g_index.entities.size()).first;
+					g_index.entities.push_back(ProjectedEntity{ e.id });
+				}
+				else {
+					auto & projected = g_index.entities[it->second];
+					if (!cameraChanged && sceneChangeHelper::sameTransform(projected.transform, transform) && sceneChangeHelper::sameTransform(projected.modelTransform, model)) {
+						projected.seen = true;
+						continue;
+					}
+				}
+
+				auto & projected = g_index.entities[it->second];
+				projected.transform = transform;
+				projected.modelTransform = model;
+				projected.seen = true;
+				project(projected, viewProj, viewportPos, viewportSize);
+				changed = true;
+			}
+
+			// Swap-remove the entities which weren't found
+			for (size_t i = 0; i < g_index.entities.size();) {
+				if (g_index.entities[i].seen) {
+					++i;
+					continue;
+				}
+				g_index.indices.erase(g_index.entities[i].id);
+				if (i != g_index.entities.size() - 1) {
+					g_index.entities[i] = std::move(g_index.entities.back());
+					g_index.indices[g_index.entities[i].id] = i;
+				}
+				g_index.entities.pop_back();
+				changed = true;
+			}
+
+			const auto cellSize = std::max(g_cellSize, 8);
+			if (changed || cellSize != g_index.cellSize || g_index.cells.empty())
+				rebuildGrid(cellSize, displaySize);
+		}
+
+		static void rebuildGrid(int cellSize, const ImVec2 & displaySize) noexcept {
+			g_index.cellSize = cellSize;
+			g_index.columns = std::max((int)std::ceil(displaySize.x / (float)cellSize), 1);
+			g_index.rows = std::max((int)std::ceil(displaySize.y / (float)cellSize), 1);
+
+			g_index.cells.resize((size_t)g_index.columns * g_index.rows);
+			for (auto & cell : g_index.cells)
+				cell.clear();
+
+			for (size_t i = 0; i < g_index.entities.size(); ++i) {
+				const auto & projected = g_index.entities[i];
+				if (!projected.visible)
+					continue;
+
+				const auto minCell = getCell(projected.rect.min);
+				const auto maxCell = getCell(projected.rect.max);
+				for (int y = minCell.y; y <= maxCell.y; ++y)
+					for (int x = minCell.x; x <= maxCell.x; ++x)
+						g_index.cells[y * g_index.columns + x].push_back(i);
+			}
+		}
+
+		// Projects the entity's box clipped to the near plane, so that a box crossing it keeps the part in front of the camera.
+		// It is hidden if it's entirely behind the near plane or off-screen
+		static void project(ProjectedEntity & projected, const glm::mat4 & viewProj, const glm::vec2 & viewportPos, const glm::vec2 & viewportSize) noexcept {
+			const auto mvp = viewProj * matrixHelper::getModelMatrix(projected.transform, &projected.modelTransform);
+
+			std::array<glm::vec4, 8> corners;
+			for (int i = 0; i < 8; ++i)
+				corners[i] = mvp * glm::vec4{ i & 1 ? .5f : -.5f, i & 2 ? .5f : -.5f, i & 4 ? .5f : -.5f, 1.f };
+
+			projected.visible = false;
+			bool inFront = false;
+			ScreenRect rect{ glm::vec2{ FLT_MAX }, glm::vec2{ -FLT_MAX } };
+			const auto addPoint = [&](const glm::vec4 & clip) noexcept {
+				const glm::vec2 ndc{ clip.x / clip.w, clip.y / clip.w };
+				const glm::vec2 screen{
+					viewportPos.x + (ndc.x + 1.f) * .5f * viewportSize.x,
+					viewportPos.y + (1.f - ndc.y) * .5f * viewportSize.y
+				};
+				rect.min = glm::min(rect.min, screen);
+				rect.max = glm::max(rect.max, screen);
+				inFront = true;
+			};
+
+			// Points are in front of the near plane when z >= -w, where w is at least the near distance
+			const auto nearDistance = [](const glm::vec4 & clip) noexcept { return clip.z + clip.w; };
+			for (int i = 0; i < 8; ++i) {
+				const auto distance = nearDistance(corners[i]);
+				if (distance >= 0.f)
+					addPoint(corners[i]);
+
+				// Edges crossing the near plane contribute their intersection with it
+				for (const int axis : { 1, 2, 4 }) {
+					if (i & axis)
+						continue;
+					const auto & other = corners[i | axis];
+					const auto otherDistance = nearDistance(other);
+					if ((distance >= 0.f) != (otherDistance >= 0.f))
+						addPoint(corners[i] + (other - corners[i]) * (distance / (distance - otherDistance)));
+				}
+			}
+
+			if (!inFront)
+				return;
+
+			projected.rect = rect;
+			projected.visible = rect.max.x >= viewportPos.x && rect.min.x <= viewportPos.x + viewportSize.x &&
+				rect.max.y >= viewportPos.y && rect.min.y <= viewportPos.y + viewportSize.y;
+		}
+
+		static EntityID getCamera(EntityID window) noexcept {
+			const auto & point = g_points[0];
+			const auto camera = cameraHelper::getViewportForPixel(window, putils::Point2f{ point.x, point.y }).camera;
+			if (camera != INVALID_ID)
+				return camera;
+
+			for (const auto & [e, cam, viewport] : entities.with<CameraComponent, ViewportComponent>())
+				return e.id;
+			return INVALID_ID;
+		}
+	};
+
+	pluginHelper::initPlugin(state);
+	impl::init();
+}
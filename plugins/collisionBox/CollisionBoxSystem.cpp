@@ -18,11 +18,13 @@
 
 #include "meta/ToSave.hpp"
 
+#include "helpers/dirtyHelper.hpp"
 #include "helpers/gizmoHelper.hpp"
 #include "helpers/ImGuizmo.h"
 #include "helpers/matrixHelper.hpp"
 #include "helpers/skeletonHelper.hpp"
 #include "helpers/typeHelper.hpp"
+#include "helpers/undoHelper.hpp"
 
 #include "imgui.h"
 #include "magic_enum.hpp"
@@ -49,7 +51,7 @@ static std::optional<ModelColliderComponent::Collider::Shape> g_shapeToAdd = std
 EXPORT void loadKenginePlugin(void * state) noexcept {
 	struct impl {
 		static void init() noexcept {
-			typeHelper::getTypeEntity<ModelColliderComponent>() += meta::ToSave{};
+			typeHelper::getTypeEntity<ModelColliderComponent>() += meta::toSave<ModelColliderComponent>();
 			entities += [](Entity & e) noexcept {
 				e += EditorComponent{ "Collisions", &g_active };
 				e += ::functions::DrawGizmos{ drawGizmos };
@@ -84,9 +86,11 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 					modelColliders.colliders.push_back({ *g_shapeToAdd });
 					modelColliders.colliders.back().transform.boundingBox.position = { 0.f, .5f, 0.f };
 					g_shapeToAdd = std::nullopt;
+					dirtyHelper::markDirty<ModelColliderComponent>(model);
 				}
 
-				for (auto & collider : modelColliders.colliders) {
+				for (std::int32_t i = 0; i < (std::int32_t)modelColliders.colliders.size(); ++i) {
+					auto & collider = modelColliders.colliders[i];
 					glm::mat4 parentMat(1.f);
 					if (!collider.boneName.empty()) {
 						kengine_assert(e.has<SkeletonComponent>() && model.has<ModelSkeletonComponent>());
@@ -103,7 +107,10 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 						parentMat *= worldSpaceBone;
 					}
 
-					gizmoHelper::drawGizmo(collider.transform, proj, view, &parentMat, true);
+					const auto manipulated = gizmoHelper::drawGizmo(collider.transform, proj, view, &parentMat, true);
+					undoHelper::trackGizmo({ model.id, i }, manipulated);
+					if (manipulated)
+						dirtyHelper::markDirty<ModelColliderComponent>(model);
 				}
 
 				e += PhysicsComponent{ 0.f };
@@ -1,4 +1,7 @@
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
 
 #include "kengine.hpp"
 #include "Export.hpp"
@@ -12,9 +15,36 @@
 
 #include "functions/Execute.hpp"
 #include "functions/GetEntityInPixel.hpp"
+#include "functions/OnSelectionChanged.hpp"
+
+#include "helpers/dirtyHelper.hpp"
+#include "helpers/hashHelper.hpp"
+#include "helpers/sceneChangeHelper.hpp"
+#include "helpers/selectionHelper.hpp"
+
+#include "imgui.h"
 
 struct HoveredComponent {};
 
+// Mouse moves only record the cursor, which is picked once per frame
+struct PendingHover {
+	kengine::EntityID window;
+	putils::Point2f coords;
+};
+static std::optional<PendingHover> g_pendingHover;
+
+// Picking results per pixel, cleared when the camera or the scene changes
+static std::unordered_map<std::uint64_t, kengine::EntityID> g_pickingCache;
+static int g_pickingCacheSize = 65536;
+static std::uint64_t g_cameraHash = 0;
+static std::uint64_t g_dirtyGeneration = 0;
+static std::uint64_t g_transformGeneration = 0;
+static bool g_wasBusy = false;
+
+// Highlights follow selection events. SelectedComponents modified without selectionHelper, e.g. by kengine's tools,
+// are caught by comparing a signature of the selection each frame, which only costs as much as the selection is large
+static std::uint64_t g_selectionSignature = 0;
+
 static putils::NormalizedColor SELECTED_COLOR;
 static float SELECTED_INTENSITY = 2.f;
 
@@ -27,14 +57,16 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 	struct impl {
 		static void init() noexcept {
 			entities += [](Entity & e) noexcept {
-				e += functions::Execute{ execute };
+				e += kengine::functions::Execute{ execute };
+				e += ::functions::OnSelectionChanged{ updateHighlight };
 
 				e += AdjustableComponent{
 					"Highlight", {
 						{ "Selected color", &SELECTED_COLOR },
 						{ "Selected intensity", &SELECTED_INTENSITY },
 						{ "Hovered color", &HOVERED_COLOR },
-						{ "Hovered intensity", &HOVERED_INTENSITY }
+						{ "Hovered intensity", &HOVERED_INTENSITY },
+						{ "Picking cache size (pixels)", &g_pickingCacheSize }
 					}
 				};
 
@@ -42,10 +74,14 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 				input.onMouseButton = [](EntityID window, int button, const putils::Point2f & coords, bool pressed) noexcept {
 					if (!pressed || button != GLFW_MOUSE_BUTTON_LEFT)
 						return;
+					// Shift and Alt drags are area selections
+					const auto & io = ImGui::GetIO();
+					if (io.KeyShift || io.KeyAlt)
+						return;
 					click(window, coords);
 				};
 				input.onMouseMove = [](EntityID window, const putils::Point2f & coords, const putils::Point2f & rel) noexcept {
-					hover(window, coords);
+					g_pendingHover = PendingHover{ window, coords };
 				};
 
 				e += input;
@@ -53,6 +89,33 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 		}
 
 		static void execute(float deltaTime) noexcept {
+			if (sceneChanged())
+				g_pickingCache.clear();
+
+			if (g_pendingHover) {
+				hover(g_pendingHover->window, g_pendingHover->coords);
+				g_pendingHover = std::nullopt;
+			}
+
+			const auto selectionSignature = getSelectionSignature();
+			if (selectionSignature != g_selectionSignature) {
+				g_selectionSignature = selectionSignature;
+				resync();
+			}
+		}
+
+		// Independent of the order in which selected entities are iterated
+		static std::uint64_t getSelectionSignature() noexcept {
+			std::uint64_t ret = 0;
+			for (const auto & [e, selected] : entities.with<SelectedComponent>()) {
+				std::uint64_t hash = hashHelper::FNV_OFFSET;
+				hashHelper::hashBytes(hash, &e.id, sizeof(e.id));
+				ret += hash;
+			}
+			return ret;
+		}
+
+		static void resync() noexcept {
 			for (auto [e, highlight, noSelected, noHovered] : entities.with<HighlightComponent, no<SelectedComponent>, no<HoveredComponent>>())
 				e.detach<HighlightComponent>();
 
@@ -60,43 +123,77 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 				e += HighlightComponent{ .color = SELECTED_COLOR, .intensity = SELECTED_INTENSITY };
 		}
 
-		static void click(EntityID window, const putils::Point2f & coords) noexcept {
+		static void updateHighlight(EntityID id, bool selected) noexcept {
+			auto e = entities[id];
+			if (selected)
+				e += HighlightComponent{ .color = SELECTED_COLOR, .intensity = SELECTED_INTENSITY };
+			else if (e.has<HoveredComponent>())
+				e += HighlightComponent{ .color = HOVERED_COLOR, .intensity = HOVERED_INTENSITY };
+			else if (e.has<HighlightComponent>())
+				e.detach<HighlightComponent>();
+		}
+
+		// Editors mark the components they modify dirty, instances moved by anything else (physics, scripts...) change
+		// the transform generation, and systems that load or remove entities are busy until they're done
+		static bool sceneChanged() noexcept {
+			const auto cameraHash = sceneChangeHelper::getCameraHash();
+			const auto dirtyGeneration = dirtyHelper::getGeneration();
+			const auto transformGeneration = sceneChangeHelper::getTransformGeneration();
+			const auto busy = sceneChangeHelper::isBusy();
+
+			// Kengine's own tools modify components without marking them dirty while the mouse is held
+			const bool dragging = ImGui::IsAnyMouseDown();
+
+			const bool changed = cameraHash != g_cameraHash || dirtyGeneration != g_dirtyGeneration || transformGeneration != g_transformGeneration ||
+				busy || g_wasBusy || dragging;
+			g_cameraHash = cameraHash;
+			g_dirtyGeneration = dirtyGeneration;
+			g_transformGeneration = transformGeneration;
+			g_wasBusy = busy;
+			return changed;
+		}
+
+		static EntityID getEntityInPixel(EntityID window, const putils::Point2f & coords) noexcept {
+			const auto key = ((std::uint64_t)window << 40) | ((std::uint64_t)((int)coords.x & 0xfffff) << 20) | (std::uint64_t)((int)coords.y & 0xfffff);
+			const auto it = g_pickingCache.find(key);
+			if (it != g_pickingCache.end())
+				return it->second;
+
 			EntityID id = INVALID_ID;
-			for (const auto & [e, func] : entities.with<functions::GetEntityInPixel>()) {
+			for (const auto & [e, func] : entities.with<kengine::functions::GetEntityInPixel>()) {
 				id = func(window, coords);
 				if (id != INVALID_ID)
 					break;
 			}
 
+			if (g_pickingCache.size() >= (size_t)std::max(g_pickingCacheSize, 0))
+				g_pickingCache.clear();
+			g_pickingCache[key] = id;
+			return id;
+		}
+
+		static void click(EntityID window, const putils::Point2f & coords) noexcept {
+			const auto id = getEntityInPixel(window, coords);
 			if (id == INVALID_ID)
 				return;
 
 			auto e = entities[id];
-			if (e.has<SelectedComponent>())
-				e.detach<SelectedComponent>();
-			else {
-				e += SelectedComponent{};
-				e += HighlightComponent{ .color = SELECTED_COLOR,.intensity = SELECTED_INTENSITY };
-			}
+			selectionHelper::toggle(e);
 		}
 
 		static void hover(EntityID window, const putils::Point2f & coords) noexcept {
 			static EntityID previous = INVALID_ID;
 
-			EntityID hovered = INVALID_ID;
-			for (const auto & [e, func] : entities.with<functions::GetEntityInPixel>()) {
-				hovered = func(window, coords);
-				if (hovered != INVALID_ID)
-					break;
-			}
-
+			const auto hovered = getEntityInPixel(window, coords);
 			if (hovered == previous)
 				return;
 
 			if (previous != INVALID_ID) {
 				auto e = entities[previous];
-				if (e.has<HoveredComponent>())
+				if (e.has<HoveredComponent>()) {
 					e.detach<HoveredComponent>();
+					updateHighlight(e.id, e.has<SelectedComponent>());
+				}
 
 				previous = INVALID_ID;
 			}
@@ -1,27 +1,125 @@
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <optional>
+#include <thread>
 #include "helpers/pluginHelper.hpp"
 
 #include "Export.hpp"
 #include "kengine.hpp"
 
+#include "data/AdjustableComponent.hpp"
 #include "data/ImGuiMainMenuBarItemComponent.hpp"
+#include "data/WatchedFilesComponent.hpp"
 #include "functions/Execute.hpp"
+#include "functions/OnTerminate.hpp"
+#include "functions/IsBusy.hpp"
 #include "meta/LoadFromJSON.hpp"
 
+#include "helpers/assertHelper.hpp"
 #include "helpers/jsonHelper.hpp"
+#include "helpers/jsonStreamHelper.hpp"
 
 #include "imgui.h"
 #include "helpers/imfilebrowser.h"
 
 using namespace kengine;
 
+// Scene being parsed on its own thread. Entities are handed to the main thread through a bounded queue,
+// so memory stays bounded by a few entities even if instantiation falls behind
+struct SceneLoad {
+	std::string path;
+	std::atomic<float> progress = 0.f;
+	std::atomic<bool> cancelled = false;
+
+	std::mutex mutex;
+	std::condition_variable queueNotFull;
+	std::deque<putils::json> queue;
+	bool parsingDone = false;
+
+	size_t created = 0;
+	std::future<bool> result;
+	std::thread thread; // Joined by cancelLoad and finishLoad, so the parser never outlives the load or the module
+};
+static std::shared_ptr<SceneLoad> g_sceneLoad;
+
+static constexpr size_t MAX_QUEUED_ENTITIES = 256;
+
+static std::vector<EntityID> g_sceneEntities;
+// Entities of the previous scene, removed over the next frames
+static std::vector<EntityID> g_toRemove;
+
+static float g_frameBudgetMs = 4.f;
+
+static EntityID g_id = INVALID_ID;
+
+static constexpr auto DEFAULT_SCENE = "resources/default_scene.json";
+
+// Left behind when the plugin is unloaded, so that a reloaded build takes over the open scene instead of loading the default one
+struct SceneHandoverComponent {
+	std::string path;
+	bool complete = true; // The scene is loaded again if it was still loading
+	std::vector<EntityID> sceneEntities;
+	std::vector<EntityID> toRemove;
+};
+
+// Runs on the parsing thread: must not touch the entity pools
+static bool parseScene(SceneLoad & load) noexcept {
+	const auto setDone = [&] {
+		const std::lock_guard lock(load.mutex);
+		load.parsingDone = true;
+	};
+
+	std::ifstream f(load.path);
+	if (!f) {
+		setDone();
+		return false;
+	}
+
+	std::error_code error;
+	const auto size = std::filesystem::file_size(load.path, error);
+
+	const bool ret = jsonStreamHelper::forEachElement(f,
+		[&](putils::json && jsonEntity) noexcept {
+			std::unique_lock lock(load.mutex);
+			load.queueNotFull.wait(lock, [&] { return load.queue.size() < MAX_QUEUED_ENTITIES || load.cancelled; });
+			if (!load.cancelled)
+				load.queue.push_back(std::move(jsonEntity));
+		},
+		[&](size_t bytesRead) noexcept {
+			if (!error && size > 0)
+				load.progress = (float)bytesRead / (float)size;
+			return !load.cancelled;
+		}
+	);
+
+	setDone();
+	return ret;
+}
+
+static std::shared_ptr<SceneLoad> startSceneLoad(const char * path) noexcept {
+	const auto load = std::make_shared<SceneLoad>();
+	load->path = path;
+
+	// Parsing waits for the main thread whenever the queue is full, which would hold a pool worker for the whole load
+	std::packaged_task<bool()> task([load = load.get()]() noexcept {
+		return parseScene(*load);
+	});
+	load->result = task.get_future();
+	load->thread = std::thread(std::move(task));
+	return load;
+}
+
 EXPORT void loadKenginePlugin(void * state) noexcept {
 	struct impl {
 		static void init() noexcept {
-			loadScene("resources/default_scene.json");
-
 			entities += [](Entity & e) noexcept {
+				g_id = e.id;
 				static ImGui::FileBrowser dialog;
 				dialog.SetTitle("Load scene");
 				dialog.SetTypeFilters({ ".json" });
@@ -29,38 +127,160 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 				e += ImGuiMainMenuBarItemComponent{ "File", "Load scene", []() noexcept {
 					if (ImGui::MenuItem("Load scene"))
 						dialog.Open();
+					drawProgress();
 				} };
 
-				e += functions::Execute{ [](float deltaTime) noexcept {
+				e += kengine::functions::Execute{ [](float deltaTime) noexcept {
 					dialog.Display();
 
 					if (dialog.HasSelected()) {
 						loadScene(dialog.GetSelected().string().c_str());
 						dialog.ClearSelected();
 					}
+
+					processScene();
 				} };
+
+				e += kengine::functions::OnTerminate{ handOver };
+				e += ::functions::IsBusy{ []() noexcept { return g_sceneLoad != nullptr || !g_toRemove.empty(); } };
+				e += WatchedFilesComponent{ .onChange = [](const char * path) noexcept { loadScene(path); } };
+
+				e += AdjustableComponent{
+					"Scene", {
+						{ "Loading budget per frame (ms)", &g_frameBudgetMs }
+					}
+				};
+			};
+
+			if (!takeOver())
+				loadScene(DEFAULT_SCENE); // Parsed on its own thread while the other plugins are being loaded
+		}
+
+		// Also stops the parser, which runs this module's code
+		static void handOver() noexcept {
+			const bool complete = g_sceneLoad == nullptr;
+			cancelLoad();
+
+			const auto & files = entities[g_id].get<WatchedFilesComponent>().files;
+			if (files.empty())
+				return;
+
+			SceneHandoverComponent handover{ files.front(), complete, std::move(g_sceneEntities), std::move(g_toRemove) };
+			entities += [&](Entity & e) noexcept {
+				e += std::move(handover);
 			};
 		}
 
+		static bool takeOver() noexcept {
+			std::optional<SceneHandoverComponent> handover;
+			EntityID handoverID = INVALID_ID;
+			for (auto [e, previous] : entities.with<SceneHandoverComponent>()) {
+				handover = std::move(previous);
+				handoverID = e.id;
+				break;
+			}
+			if (!handover)
+				return false;
+			entities -= handoverID;
+
+			g_sceneEntities = std::move(handover->sceneEntities);
+			g_toRemove = std::move(handover->toRemove);
+			if (handover->complete)
+				entities[g_id].get<WatchedFilesComponent>().files = { handover->path };
+			else
+				loadScene(handover->path.c_str());
+			return true;
+		}
+
+		static void drawProgress() noexcept {
+			if (!g_toRemove.empty())
+				ImGui::Text("Unloading previous scene (%zu entities left)", g_toRemove.size());
+
+			if (g_sceneLoad) {
+				ImGui::Text("Loading %s (%zu entities)", g_sceneLoad->path.c_str(), g_sceneLoad->created);
+				ImGui::ProgressBar(g_sceneLoad->progress);
+				if (ImGui::MenuItem("Cancel scene loading"))
+					cancelLoad();
+			}
+		}
+
 		static void loadScene(const char * path) noexcept {
-			static std::vector<EntityID> toRemove;
+			cancelLoad();
+
+			g_toRemove.insert(g_toRemove.end(), g_sceneEntities.begin(), g_sceneEntities.end());
+			g_sceneEntities.clear();
+
+			g_sceneLoad = startSceneLoad(path);
+
+			// Reload the scene when it changes on disk
+			entities[g_id].get<WatchedFilesComponent>().files = { path };
+		}
 
-			for (const auto id : toRemove)
-				entities -= id;
-			toRemove.clear();
+		static void cancelLoad() noexcept {
+			if (!g_sceneLoad)
+				return;
+
+			{
+				const std::lock_guard lock(g_sceneLoad->mutex);
+				g_sceneLoad->cancelled = true;
+			}
+			g_sceneLoad->queueNotFull.notify_one();
+
+			// The parser checks the flag between the chunks it reads, so this doesn't block for long
+			g_sceneLoad->thread.join();
+			g_sceneLoad = nullptr;
+		}
+
+		// Removes the previous scene, then instantiates the new one, spending at most g_frameBudgetMs per frame
+		static void processScene() noexcept {
+			const auto start = std::chrono::steady_clock::now();
+			const auto budget = std::chrono::duration<float, std::milli>(g_frameBudgetMs);
+			const auto hasTime = [&] { return std::chrono::steady_clock::now() - start < budget; };
+
+			while (!g_toRemove.empty() && hasTime()) {
+				entities -= g_toRemove.back();
+				g_toRemove.pop_back();
+			}
 
-			std::ifstream f(path);
-			if (!f)
+			if (!g_toRemove.empty() || !g_sceneLoad)
 				return;
-			const auto json = putils::json::parse(f);
 
-			for (const auto & jsonEntity : json) {
-				const auto e = jsonHelper::createEntity(jsonEntity);
-				toRemove.push_back(e.id);
+			while (hasTime()) {
+				std::optional<putils::json> jsonEntity;
+				bool done = false;
+				{
+					const std::lock_guard lock(g_sceneLoad->mutex);
+					if (g_sceneLoad->queue.empty())
+						done = g_sceneLoad->parsingDone;
+					else {
+						jsonEntity = std::move(g_sceneLoad->queue.front());
+						g_sceneLoad->queue.pop_front();
+					}
+				}
+
+				if (!jsonEntity) {
+					if (done)
+						finishLoad();
+					return;
+				}
+
+				g_sceneLoad->queueNotFull.notify_one();
+
+				const auto e = jsonHelper::createEntity(*jsonEntity);
+				g_sceneEntities.push_back(e.id);
+				++g_sceneLoad->created;
 			}
 		}
+
+		// parsingDone is set right before the task returns, so this doesn't block
+		static void finishLoad() noexcept {
+			const auto load = std::move(g_sceneLoad);
+			load->thread.join();
+			if (!load->result.get())
+				kengine_assert_failed("Failed to parse '", load->path, "'");
+		}
 	};
 
 	pluginHelper::initPlugin(state);
 	impl::init();
-}
\ No newline at end of file
+}
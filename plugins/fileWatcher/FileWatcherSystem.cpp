@@ -0,0 +1,67 @@
+#include <filesystem>
+#include <unordered_set>
+
+#include "kengine.hpp"
+#include "Export.hpp"
+#include "helpers/pluginHelper.hpp"
+
+#include "data/AdjustableComponent.hpp"
+#include "data/WatchedFilesComponent.hpp"
+
+#include "functions/Execute.hpp"
+
+#include "helpers/fileWatcherHelper.hpp"
+
+using namespace kengine;
+
+static std::unique_ptr<fileWatcherHelper::Watcher> g_watcher;
+static int g_debounceMs = 200;
+
+EXPORT void loadKenginePlugin(void * state) noexcept {
+	struct impl {
+		static void init() noexcept {
+			g_watcher = std::make_unique<fileWatcherHelper::Watcher>();
+
+			entities += [](Entity & e) noexcept {
+				e += functions::Execute{ execute };
+				e += AdjustableComponent{
+					"File watcher", {
+						{ "Debounce (ms)", &g_debounceMs }
+					}
+				};
+			};
+		}
+
+		static void execute(float deltaTime) noexcept {
+			std::vector<std::string> files;
+			for (const auto & [e, watched] : entities.with<WatchedFilesComponent>())
+				for (const auto & file : watched.files)
+					files.push_back(normalize(file));
+			g_watcher->setFiles(files);
+
+			const auto changed = g_watcher->poll(std::chrono::milliseconds(g_debounceMs));
+			if (changed.empty())
+				return;
+
+			const std::unordered_set<std::string> changedSet(changed.begin(), changed.end());
+			for (const auto & [e, watched] : entities.with<WatchedFilesComponent>()) {
+				// Copy, as onChange may modify the list
+				const auto watchedFiles = watched.files;
+				for (const auto & file : watchedFiles)
+					if (changedSet.contains(normalize(file)))
+						watched.onChange(file.c_str());
+			}
+		}
+
+		static std::string normalize(const std::string & path) noexcept {
+			std::error_code error;
+			const auto absolute = std::filesystem::absolute(path, error);
+			if (error)
+				return path;
+			return absolute.lexically_normal().string();
+		}
+	};
+
+	pluginHelper::initPlugin(state);
+	impl::init();
+}
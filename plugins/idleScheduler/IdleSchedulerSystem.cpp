@@ -0,0 +1,81 @@
+#include <GLFW/glfw3.h>
+#include "kengine.hpp"
+#include "Export.hpp"
+#include "helpers/pluginHelper.hpp"
+
+#include "data/AdjustableComponent.hpp"
+#include "data/GLFWWindowComponent.hpp"
+#include "data/InputComponent.hpp"
+
+#include "functions/Execute.hpp"
+
+#include "helpers/dirtyHelper.hpp"
+#include "helpers/sceneChangeHelper.hpp"
+
+using namespace kengine;
+
+// Once nothing has happened for `g_idleDelay`, frames are only run when GLFW receives an event or every `g_idleFrameMs`
+static bool g_enabled = true;
+static float g_idleDelay = 1.f; // In seconds, lets ImGui settle after the last input
+static int g_idleFrameMs = 250;
+
+static float g_timeSinceActivity = 0.f;
+static std::uint64_t g_dirtyGeneration = 0;
+
+EXPORT void loadKenginePlugin(void * state) noexcept {
+	struct impl {
+		static void init() noexcept {
+			entities += [](Entity & e) noexcept {
+				e += kengine::functions::Execute{ execute };
+
+				InputComponent input;
+				input.onKey = [](EntityID window, int key, bool pressed) noexcept { onInput(); };
+				input.onMouseButton = [](EntityID window, int button, const putils::Point2f & coords, bool pressed) noexcept { onInput(); };
+				input.onMouseMove = [](EntityID window, const putils::Point2f & coords, const putils::Point2f & rel) noexcept { onInput(); };
+				input.onScroll = [](EntityID window, float deltaX, float deltaY, const putils::Point2f & coords) noexcept { onInput(); };
+				e += input;
+
+				e += AdjustableComponent{
+					"Idle scheduler", {
+						{ "Enabled", &g_enabled },
+						{ "Idle delay (s)", &g_idleDelay },
+						{ "Idle frame interval (ms)", &g_idleFrameMs }
+					}
+				};
+			};
+		}
+
+		static void onInput() noexcept {
+			g_timeSinceActivity = 0.f;
+		}
+
+		static void execute(float deltaTime) noexcept {
+			if (isActive())
+				g_timeSinceActivity = 0.f;
+			else
+				g_timeSinceActivity += deltaTime;
+
+			if (!g_enabled || g_timeSinceActivity < g_idleDelay)
+				return;
+
+			// Headless runs have no window to wait on
+			for (const auto & [e, window] : entities.with<GLFWWindowComponent>()) {
+				// Events received while waiting are dispatched to the InputComponents on the next frame, which resets the idle delay
+				glfwWaitEventsTimeout((double)g_idleFrameMs / 1000.0);
+				return;
+			}
+		}
+
+		static bool isActive() noexcept {
+			// Dirty components accumulate until the next save, so only new edits count as activity
+			const auto dirtyGeneration = dirtyHelper::getGeneration();
+			const bool edited = dirtyGeneration != g_dirtyGeneration;
+			g_dirtyGeneration = dirtyGeneration;
+
+			return edited || sceneChangeHelper::isBusy();
+		}
+	};
+
+	pluginHelper::initPlugin(state);
+	impl::init();
+}
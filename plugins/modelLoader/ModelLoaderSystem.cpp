@@ -1,7 +1,12 @@
 #include <filesystem>
 #include <unordered_set>
+#include <unordered_map>
 #include <vector>
 #include <fstream>
+#include <future>
+#include <atomic>
+#include <optional>
+#include <cmath>
 
 #include <GLFW/glfw3.h>
 
@@ -9,6 +14,8 @@
 #include "Export.hpp"
 #include "helpers/pluginHelper.hpp"
 
+#include "data/AdjustableComponent.hpp"
+#include "data/DirtyComponent.hpp"
 #include "data/GraphicsComponent.hpp"
 #include "data/TransformComponent.hpp"
 #include "data/InstanceComponent.hpp"
@@ -16,17 +23,19 @@
 #include "data/GLFWWindowComponent.hpp"
 #include "data/ModelComponent.hpp"
 #include "data/SelectedComponent.hpp"
+#include "data/WatchedFilesComponent.hpp"
 
 #include "functions/Execute.hpp"
 #include "functions/OnTerminate.hpp"
+#include "functions/IsBusy.hpp"
 
-#include "meta/Has.hpp"
-#include "meta/SaveToJSON.hpp"
 #include "meta/ToSave.hpp"
 
 #include "helpers/assertHelper.hpp"
 #include "helpers/jsonHelper.hpp"
-#include "helpers/sortHelper.hpp"
+#include "helpers/importCacheHelper.hpp"
+#include "helpers/modelFileHelper.hpp"
+#include "helpers/selectionHelper.hpp"
 #include "helpers/typeHelper.hpp"
 
 #include "imgui.h"
@@ -50,17 +59,130 @@ enum class ModelAction {
 static ModelAction g_modelAction;
 
 static EntityID g_currentEntity = INVALID_ID;
+static EntityID g_id = INVALID_ID;
+
+// Model kept resident so that switching back to it doesn't require importing it again
+struct WorkspaceModel {
+	std::string path;
+	std::string importPath;
+	EntityID model = INVALID_ID; // Set by ModelCreatorSystem for imported formats, so only known once the instance is switched out
+	EntityID instance = INVALID_ID; // INVALID_ID while the model isn't being viewed
+	TransformComponent transform;
+	size_t size = 0; // Size of the source file, used as an estimate of the memory footprint
+	size_t lastViewed = 0;
+};
+static std::vector<WorkspaceModel> g_workspace;
+static size_t g_viewCounter = 0;
+
+static int g_workspaceBudgetMB = 1024;
+static int g_workspaceMaxModels = 8;
+
+// Closed models still used by dropped instances, removed once the last of them is
+static std::vector<EntityID> g_orphanedModels;
+
+static int g_importCacheSizeMB = 2048;
+// Cooked files in the import cache, mapped to their source so that saved models reference the source
+static std::unordered_map<std::string, std::string> g_cookedSources;
+
+struct LoadedModel {
+	putils::json json; // Description of the model entity, for .json and .kmodel files
+	std::string importPath; // File to import through GraphicsComponent for other formats, may be in the import cache
+};
+
+// Model being read/parsed on the thread pool. Shared with the worker so that cancelling doesn't have to wait for it
+struct ModelLoad {
+	std::string path;
+	// Set for dropped files, which are added to the scene instead of replacing the current model
+	std::optional<putils::Point3f> position;
+	size_t maxCacheSize = 0; // Copied from the adjustable when the load starts, as workers can't read it
+	std::atomic<float> progress = 0.f;
+	std::atomic<bool> cancelled = false;
+	std::future<std::optional<LoadedModel>> result;
+};
+static std::vector<std::shared_ptr<ModelLoad>> g_loads;
+
+// Recent models read ahead of time while no load is running, so that opening them is immediate
+struct PrefetchedModel {
+	LoadedModel loaded;
+	std::filesystem::file_time_type lastWrite;
+};
+static std::unordered_map<std::string, PrefetchedModel> g_prefetched;
+static std::unordered_set<std::string> g_prefetchFailures;
+static std::shared_ptr<ModelLoad> g_prefetch;
+static int g_prefetchCount = 3;
+
+// Serialized components of a model, reused by its next save for the components that still serialize to the same value
+struct SaveCacheComponent {
+	modelFileHelper::SaveCache cache;
+};
+
+// Modified models are periodically written next to their file. The main thread only copies their components,
+// which are serialized, compared to the last save and written by the thread pool
+static float g_autosaveInterval = 30.f; // In seconds, 0 disables autosave
+static float g_timeSinceAutosave = 0.f;
+struct AutosaveResult {
+	bool written = false;
+	modelFileHelper::SaveCache cache; // Installed on the model once the autosave is done
+};
+static std::future<AutosaveResult> g_autosave;
+static std::string g_autosavePath;
+static EntityID g_autosaveModel = INVALID_ID;
+
+// Files written by saves, with their modification time, so that the file watcher reporting them doesn't reload the model
+static std::unordered_map<std::string, std::filesystem::file_time_type> g_ownWrites;
+
+// Tags windows whose drop callback has been set
+struct DropCallbackComponent {};
+
+static float g_dropGridSpacing = 2.f;
+
+static constexpr size_t LOAD_CHUNK_SIZE = 1024 * 1024;
+
+template<typename Pred>
+static void cancelLoads(Pred && pred) noexcept {
+	const auto it = std::remove_if(g_loads.begin(), g_loads.end(), [&](const auto & load) noexcept {
+		if (!pred(*load))
+			return false;
+		load->cancelled = true;
+		return true;
+	});
+	g_loads.erase(it, g_loads.end());
+}
+
+// Reads the recent models and sizes the import cache while the other plugins are being loaded
+EXPORT void prepareKenginePlugin(void * state) noexcept {
+	importCacheHelper::getCacheSize();
+
+	std::ifstream f(RECENT_FILE);
+
+	if (!f)
+		return;
+
+	for (std::string s; std::getline(f, s);)
+		g_recentItems.push_back(s);
+}
 
 EXPORT void loadKenginePlugin(void * state) noexcept {
 	struct impl {
 		static void init() noexcept {
-			loadRecentItems();
-
-			typeHelper::getTypeEntity<ModelComponent>() += ::meta::ToSave{};
+			typeHelper::getTypeEntity<ModelComponent>() += ::meta::toSave<ModelComponent>();
 
 			entities += [](Entity & e) noexcept {
-				e += functions::Execute{ execute };
-				e += functions::OnTerminate{ saveRecentItems };
+				g_id = e.id;
+				e += kengine::functions::Execute{ execute };
+				e += kengine::functions::OnTerminate{ onTerminate };
+				e += ::functions::IsBusy{ []() noexcept { return !g_loads.empty() || g_prefetch != nullptr || g_autosave.valid(); } };
+				e += WatchedFilesComponent{ .onChange = reloadModel };
+				e += AdjustableComponent{
+					"Model loader", {
+						{ "Drop grid spacing", &g_dropGridSpacing },
+						{ "Workspace memory budget (MB)", &g_workspaceBudgetMB },
+						{ "Workspace max models", &g_workspaceMaxModels },
+						{ "Import cache size (MB)", &g_importCacheSizeMB },
+						{ "Prefetched recent models", &g_prefetchCount },
+						{ "Autosave interval (s)", &g_autosaveInterval }
+					}
+				};
 			};
 
 			entities += [=](Entity & e) noexcept {
@@ -75,6 +197,19 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 							}
 						}
 
+						if (!g_loads.empty())
+							drawLoads();
+
+						if (ImGui::BeginMenu("Workspace", !g_workspace.empty())) {
+							drawWorkspace();
+							ImGui::EndMenu();
+						}
+
+						// Loads may be about to import a cooked file
+						const auto purgeLabel = putils::concat("Purge import cache (", importCacheHelper::getCacheSize() / (1024 * 1024), " MB)");
+						if (ImGui::MenuItem(purgeLabel.c_str(), nullptr, false, g_loads.empty() && g_prefetch == nullptr))
+							purgeImportCache();
+
 						if (ImGui::BeginMenu("Recent")) {
 							for (const auto & f : g_recentItems)
 								if (ImGui::MenuItem(f.c_str()))
@@ -88,14 +223,65 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 			};
 		}
 
-		static void loadRecentItems() noexcept {
-			std::ifstream f(RECENT_FILE);
+		// Cooked files of resident and prefetched models are kept, as they're imported again when viewing these
+		static void purgeImportCache() noexcept {
+			std::unordered_set<std::string> referenced;
+			for (const auto & model : g_workspace)
+				referenced.insert(model.importPath);
+			for (const auto & [path, prefetched] : g_prefetched)
+				referenced.insert(prefetched.loaded.importPath);
+			importCacheHelper::purge(referenced);
+		}
 
-			if (!f)
-				return;
+		static void drawLoads() noexcept {
+			ImGui::Separator();
+
+			std::shared_ptr<ModelLoad> toCancel;
+			for (const auto & load : g_loads) {
+				ImGui::PushID(load.get());
+				ImGui::Text("Loading %s", load->path.c_str());
+				ImGui::ProgressBar(load->progress);
+				if (ImGui::MenuItem("Cancel"))
+					toCancel = load;
+				ImGui::PopID();
+			}
+
+			if (g_loads.size() > 1 && ImGui::MenuItem("Cancel all"))
+				cancelLoads([](const ModelLoad &) { return true; });
+			else if (toCancel)
+				cancelLoads([&](const ModelLoad & load) { return &load == toCancel.get(); });
+
+			ImGui::Separator();
+		}
+
+		static void drawWorkspace() noexcept {
+			const WorkspaceModel * toView = nullptr;
+			for (const auto & model : g_workspace)
+				if (ImGui::MenuItem(model.path.c_str(), nullptr, model.instance != INVALID_ID))
+					toView = &model;
+
+			ImGui::Separator();
+			if (ImGui::MenuItem("Close current model", nullptr, false, g_currentEntity != INVALID_ID))
+				closeCurrentModel();
+
+			if (toView != nullptr && toView->instance == INVALID_ID) {
+				const auto path = toView->path; // viewModel may modify g_workspace
+				viewModel(path);
+			}
+		}
 
-			for (std::string s; std::getline(f, s);)
-				g_recentItems.push_back(s);
+		// Also called when the plugin is unloaded: windows must no longer call into this module
+		static void onTerminate() noexcept {
+			cancelLoads([](const ModelLoad &) { return true; });
+			cancelPrefetch();
+			finishAutosave(true);
+			importCacheHelper::waitForCooks();
+			saveRecentItems();
+
+			for (auto [e, window, callback] : entities.with<GLFWWindowComponent, DropCallbackComponent>()) {
+				glfwSetDropCallback(window.window.get(), nullptr);
+				e.detach<DropCallbackComponent>();
+			}
 		}
 
 		static void saveRecentItems() noexcept {
@@ -125,37 +311,421 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 				}
 			}
 
-			for (const auto & [e, window] : entities.with<GLFWWindowComponent>()) {
-				glfwSetDropCallback(window.window.get(), [](GLFWwindow * window, int nbFiles, const char ** files) noexcept {
-					kengine_assert(nbFiles >= 1);
-					loadModel(files[0]);
-				});
+			processLoads();
+			processPrefetch();
+			removeOrphanedModels();
+			watchCurrentModel();
+			autosave(deltaTime);
+
+			for (auto [e, window, noCallback] : entities.with<GLFWWindowComponent, no<DropCallbackComponent>>()) {
+				glfwSetDropCallback(window.window.get(), onDrop);
+				e += DropCallbackComponent{};
+			}
+		}
+
+		// Each dropped file is loaded concurrently and laid out on a grid centered on the origin
+		static void onDrop(GLFWwindow * window, int nbFiles, const char ** files) noexcept {
+			kengine_assert(nbFiles >= 1);
+
+			const auto columns = (int)std::ceil(std::sqrt((float)nbFiles));
+			const auto rows = (nbFiles + columns - 1) / columns;
+			for (int i = 0; i < nbFiles; ++i) {
+				const putils::Point3f position{
+					((float)(i % columns) - (float)(columns - 1) / 2.f) * g_dropGridSpacing,
+					0.f,
+					((float)(i / columns) - (float)(rows - 1) / 2.f) * g_dropGridSpacing
+				};
+				startLoad(files[i], position);
 			}
 		}
 
 		static void loadModel(const char * path) noexcept {
-			if (g_currentEntity != INVALID_ID) {
-				const auto e = entities[g_currentEntity];
-				if (e.has<InstanceComponent>())
-					entities -= e.get<InstanceComponent>().model;
-				else
-					kengine_assert_failed("Entity does not have model");
+			cancelLoads([](const ModelLoad & load) { return !load.position; });
 
-				entities -= e;
+			if (findWorkspaceModel(path) != g_workspace.end()) {
+				viewModel(path);
+				addToRecentItems(path);
+				return;
 			}
 
-			if (putils::file_extension(path) == "json")
-				loadFromJSON(path);
+			if (const auto prefetched = takePrefetched(path)) {
+				instantiate(path, std::nullopt, *prefetched);
+				return;
+			}
+
+			// Promote the running prefetch rather than starting over
+			if (g_prefetch && g_prefetch->path == path) {
+				g_loads.push_back(std::move(g_prefetch));
+				return;
+			}
+
+			startLoad(path, std::nullopt);
+		}
+
+		static void startLoad(const char * path, const std::optional<putils::Point3f> & position) noexcept {
+			if (position) {
+				// Dropped instances share resident models
+				const auto it = findWorkspaceModel(path);
+				if (it != g_workspace.end() && it->model != INVALID_ID) {
+					createInstance(it->model).get<TransformComponent>().boundingBox.position = *position;
+					return;
+				}
+			}
+
+			// Foreground loads take priority over prefetching
+			cancelPrefetch();
+
+			const auto load = std::make_shared<ModelLoad>();
+			load->path = path;
+			load->position = position;
+			load->maxCacheSize = getMaxCacheSize();
+			load->result = kengine::threadPool().runTask([load]() noexcept {
+				return readModel(*load);
+			});
+			g_loads.push_back(load);
+		}
+
+		// Runs on the thread pool: must not touch the entity pools
+		static std::optional<LoadedModel> readModel(ModelLoad & load) noexcept {
+			if (modelFileHelper::isModelDescription(load.path)) {
+				auto json = modelFileHelper::readDescription(load.path.c_str(), [&](float progress) noexcept {
+					load.progress = progress;
+					return !load.cancelled;
+				});
+				if (!json)
+					return std::nullopt;
+				return LoadedModel{ .json = std::move(*json) };
+			}
+
+			if (importCacheHelper::isCacheable(load.path)) {
+				const auto cached = importCacheHelper::findCachedImport(load.path.c_str(), load.maxCacheSize, [&](float progress) noexcept {
+					load.progress = progress;
+					return !load.cancelled;
+				});
+
+				if (load.cancelled)
+					return std::nullopt;
+				// On a miss the source is imported while it is cooked in the background, for the next load
+				return LoadedModel{ .importPath = cached ? *cached : load.path };
+			}
+
+			std::ifstream f(load.path, std::ifstream::binary);
+			if (!f)
+				return std::nullopt;
+
+			std::error_code error;
+			const auto size = std::filesystem::file_size(load.path, error);
+			if (error)
+				return std::nullopt;
+
+			// Other formats are imported by the model systems once GraphicsComponent is attached, reading the file here warms up the OS cache for them
+			std::vector<char> buffer(std::min(LOAD_CHUNK_SIZE, size));
+			size_t read = 0;
+			while (read < size) {
+				if (load.cancelled)
+					return std::nullopt;
+
+				f.read(buffer.data(), std::min(LOAD_CHUNK_SIZE, size - read));
+				const auto count = (size_t)f.gcount();
+				if (count == 0)
+					break;
+				read += count;
+				load.progress = (float)read / (float)size;
+			}
+
+			if (read != size)
+				return std::nullopt;
+			return LoadedModel{ .importPath = load.path };
+		}
+
+		static size_t getMaxCacheSize() noexcept {
+			return (size_t)std::max(g_importCacheSizeMB, 0) * 1024 * 1024;
+		}
+
+		static void processLoads() noexcept {
+			const auto it = std::remove_if(g_loads.begin(), g_loads.end(), [](const auto & load) noexcept {
+				if (load->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+					return false;
+				finishLoad(*load);
+				return true;
+			});
+			g_loads.erase(it, g_loads.end());
+		}
+
+		static void finishLoad(ModelLoad & load) noexcept {
+			const auto loaded = load.result.get();
+			if (!loaded) {
+				kengine_assert_failed("Failed to load '", load.path, "'");
+				return;
+			}
+
+			instantiate(load.path, load.position, *loaded);
+		}
+
+		static void instantiate(const std::string & path, const std::optional<putils::Point3f> & position, const LoadedModel & loaded) noexcept {
+			if (!position)
+				hideCurrentModel();
+
+			if (loaded.importPath != path && !loaded.importPath.empty())
+				g_cookedSources[loaded.importPath] = path;
+
+			auto e = modelFileHelper::isModelDescription(path) ? createFromJSON(loaded.json) : createFromFile(loaded.importPath.c_str());
+
+			if (position)
+				e.get<TransformComponent>().boundingBox.position = *position;
 			else {
-				entities += [&](Entity & e) noexcept {
-					g_currentEntity = e.id;
-					e += GraphicsComponent{ path };
-					e += TransformComponent{};
-					e += SelectedComponent{};
-				};
+				g_currentEntity = e.id;
+				selectionHelper::select(e);
+				addToWorkspace(path, loaded.importPath, e);
 			}
 
-			addToRecentItems(path);
+			addToRecentItems(path.c_str());
+		}
+
+		// Only one prefetch runs at a time, and only while no foreground load is running
+		static void processPrefetch() noexcept {
+			if (g_prefetch) {
+				if (g_prefetch->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+					return;
+
+				const auto prefetch = std::move(g_prefetch);
+				auto loaded = prefetch->result.get();
+				if (!loaded) {
+					g_prefetchFailures.insert(prefetch->path);
+					return;
+				}
+
+				std::error_code error;
+				const auto lastWrite = std::filesystem::last_write_time(prefetch->path, error);
+				if (!error)
+					g_prefetched[prefetch->path] = PrefetchedModel{ std::move(*loaded), lastWrite };
+				return;
+			}
+
+			if (!g_loads.empty())
+				return;
+
+			// Drop models that aren't among the top recent items anymore
+			const auto end = std::next(g_recentItems.begin(), std::min(g_recentItems.size(), (size_t)std::max(g_prefetchCount, 0)));
+			for (auto it = g_prefetched.begin(); it != g_prefetched.end();) {
+				if (std::find(g_recentItems.begin(), end, it->first) == end)
+					it = g_prefetched.erase(it);
+				else
+					++it;
+			}
+
+			for (auto it = g_recentItems.begin(); it != end; ++it) {
+				const auto & path = *it;
+				if (g_prefetched.contains(path) || g_prefetchFailures.contains(path) || findWorkspaceModel(path) != g_workspace.end())
+					continue;
+
+				const auto prefetch = std::make_shared<ModelLoad>();
+				prefetch->path = path;
+				prefetch->maxCacheSize = getMaxCacheSize();
+				prefetch->result = kengine::threadPool().runTask([prefetch]() noexcept {
+					return readModel(*prefetch);
+				});
+				g_prefetch = prefetch;
+				return;
+			}
+		}
+
+		static void cancelPrefetch() noexcept {
+			if (!g_prefetch)
+				return;
+			// readModel checks this between chunks, so the worker is freed right away
+			g_prefetch->cancelled = true;
+			g_prefetch = nullptr;
+		}
+
+		static std::optional<LoadedModel> takePrefetched(const std::string & path) noexcept {
+			const auto it = g_prefetched.find(path);
+			if (it == g_prefetched.end())
+				return std::nullopt;
+
+			auto prefetched = std::move(it->second);
+			g_prefetched.erase(it);
+
+			// The file changed since it was prefetched
+			std::error_code error;
+			if (std::filesystem::last_write_time(path, error) != prefetched.lastWrite || error)
+				return std::nullopt;
+			return std::move(prefetched.loaded);
+		}
+
+		static auto findWorkspaceModel(std::string_view path) noexcept {
+			return std::find_if(g_workspace.begin(), g_workspace.end(), [&](const WorkspaceModel & model) noexcept {
+				return model.path == path;
+			});
+		}
+
+		static void addToWorkspace(const std::string & path, const std::string & importPath, const Entity & instance) noexcept {
+			WorkspaceModel model;
+			model.path = path;
+			model.importPath = importPath;
+			model.instance = instance.id;
+			if (const auto instanceComp = instance.tryGet<InstanceComponent>())
+				model.model = instanceComp->model;
+			model.lastViewed = ++g_viewCounter;
+
+			std::error_code error;
+			model.size = (size_t)std::filesystem::file_size(path, error);
+			if (error)
+				model.size = 0;
+
+			g_workspace.push_back(std::move(model));
+			enforceWorkspaceBudget();
+		}
+
+		// Switching only creates an instance entity for the already resident model
+		static void viewModel(const std::string & path) noexcept {
+			hideCurrentModel();
+
+			const auto it = findWorkspaceModel(path);
+			if (it == g_workspace.end())
+				return;
+
+			auto e = it->model != INVALID_ID ? createInstance(it->model) : createFromFile(it->importPath.c_str());
+			e.get<TransformComponent>() = it->transform;
+			selectionHelper::select(e);
+
+			g_currentEntity = e.id;
+			it->instance = e.id;
+			it->lastViewed = ++g_viewCounter;
+		}
+
+		// Removes the current instance but keeps its model resident in the workspace
+		static void hideCurrentModel() noexcept {
+			if (g_currentEntity == INVALID_ID)
+				return;
+
+			const auto e = entities[g_currentEntity];
+			const auto it = std::find_if(g_workspace.begin(), g_workspace.end(), [](const WorkspaceModel & model) noexcept {
+				return model.instance == g_currentEntity;
+			});
+
+			if (it != g_workspace.end()) {
+				const auto instance = e.tryGet<InstanceComponent>();
+				if (instance && instance->model != INVALID_ID) {
+					it->model = instance->model;
+					it->transform = e.get<TransformComponent>();
+					it->instance = INVALID_ID;
+					it->lastViewed = ++g_viewCounter;
+				}
+				else // Model hasn't been created yet
+					g_workspace.erase(it);
+			}
+
+			entities -= e;
+			g_currentEntity = INVALID_ID;
+		}
+
+		static void watchCurrentModel() noexcept {
+			auto & watched = entities[g_id].get<WatchedFilesComponent>();
+			watched.files.clear();
+			for (const auto & model : g_workspace)
+				if (model.instance != INVALID_ID)
+					watched.files.push_back(model.path);
+		}
+
+		static void reloadModel(const char * path) noexcept {
+			const auto ownWrite = g_ownWrites.find(normalize(path));
+			if (ownWrite != g_ownWrites.end()) {
+				std::error_code error;
+				if (std::filesystem::last_write_time(path, error) == ownWrite->second && !error)
+					return;
+			}
+
+			const auto it = findWorkspaceModel(path);
+			if (it == g_workspace.end() || it->instance != g_currentEntity)
+				return;
+
+			closeCurrentModel();
+			g_prefetched.erase(path);
+			loadModel(path);
+		}
+
+		static std::string normalize(const char * path) noexcept {
+			std::error_code error;
+			const auto absolute = std::filesystem::absolute(path, error);
+			if (error)
+				return path;
+			return absolute.lexically_normal().string();
+		}
+
+		static void closeCurrentModel() noexcept {
+			if (g_currentEntity == INVALID_ID)
+				return;
+
+			const auto e = entities[g_currentEntity];
+			auto model = INVALID_ID;
+			if (e.has<InstanceComponent>())
+				model = e.get<InstanceComponent>().model;
+			else
+				kengine_assert_failed("Entity does not have model");
+
+			const auto it = std::find_if(g_workspace.begin(), g_workspace.end(), [](const WorkspaceModel & model) noexcept {
+				return model.instance == g_currentEntity;
+			});
+			if (it != g_workspace.end())
+				g_workspace.erase(it);
+
+			entities -= e;
+			g_currentEntity = INVALID_ID;
+
+			// Dropped instances keep the model alive, it's removed along with the last of them
+			if (model == INVALID_ID)
+				return;
+			if (isModelUsed(model))
+				g_orphanedModels.push_back(model);
+			else
+				entities -= model;
+		}
+
+		// Evicts the least recently viewed models until the workspace fits in its budget
+		static void enforceWorkspaceBudget() noexcept {
+			const auto budget = (size_t)std::max(g_workspaceBudgetMB, 0) * 1024 * 1024;
+
+			while (true) {
+				size_t total = 0;
+				for (const auto & model : g_workspace)
+					total += model.size;
+
+				if (total <= budget && g_workspace.size() <= (size_t)std::max(g_workspaceMaxModels, 1))
+					return;
+
+				auto lru = g_workspace.end();
+				for (auto it = g_workspace.begin(); it != g_workspace.end(); ++it) {
+					if (it->instance != INVALID_ID || isModelUsed(it->model))
+						continue;
+					if (lru == g_workspace.end() || it->lastViewed < lru->lastViewed)
+						lru = it;
+				}
+
+				if (lru == g_workspace.end())
+					return;
+
+				entities -= lru->model;
+				g_workspace.erase(lru);
+			}
+		}
+
+		static void removeOrphanedModels() noexcept {
+			const auto it = std::remove_if(g_orphanedModels.begin(), g_orphanedModels.end(), [](EntityID model) noexcept {
+				if (isModelUsed(model))
+					return false;
+				entities -= model;
+				return true;
+			});
+			g_orphanedModels.erase(it, g_orphanedModels.end());
+		}
+
+		// Dropped instances may still be using the model
+		static bool isModelUsed(EntityID model) noexcept {
+			for (const auto & [e, instance] : entities.with<InstanceComponent>())
+				if (instance.model == model)
+					return true;
+			return false;
 		}
 
 		static void addToRecentItems(const char * path) noexcept {
@@ -166,21 +736,33 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 				g_recentItems.push_front(path);
 		}
 
-		static void loadFromJSON(const char * path) noexcept {
-			std::ifstream f(path);
-			if (!f) {
-				kengine_assert_failed("Failed to open '", path, "'");
-				return;
-			}
+		static Entity createFromFile(const char * path) noexcept {
+			return entities += [&](Entity & e) noexcept {
+				e += GraphicsComponent{ path };
+				e += TransformComponent{};
+			};
+		}
 
-			const auto modelJSON = putils::json::parse(f);
-			const auto model = jsonHelper::createEntity(modelJSON);
-			entities += [&](Entity & e) noexcept {
-				g_currentEntity = e.id;
-				e += InstanceComponent{ model.id };
+		static Entity createFromJSON(const putils::json & modelJSON) noexcept {
+			auto model = jsonHelper::createEntity(modelJSON);
+
+			// The components as they are in the file, so that autosaves can tell whether the model was modified
+			auto & cache = model.attach<SaveCacheComponent>().cache;
+			if (modelJSON.is_object())
+				for (const auto & [name, value] : modelJSON.items()) {
+					const auto component = std::make_shared<modelFileHelper::SaveCache::Component>();
+					component->value = value;
+					cache.components.emplace(name, component);
+				}
+
+			return createInstance(model.id);
+		}
+
+		static Entity createInstance(EntityID model) noexcept {
+			return entities += [&](Entity & e) noexcept {
+				e += InstanceComponent{ model };
 				e += GraphicsComponent{};
 				e += TransformComponent{};
-				e += SelectedComponent{};
 			};
 		}
 
@@ -188,39 +770,120 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 			if (g_currentEntity == INVALID_ID)
 				return;
 
-			std::ofstream f(path);
-			if (!f) {
-				kengine_assert_failed("Could not open '", path, "' for writing");
-				return;
-			}
-
 			const auto e = entities[g_currentEntity];
 			const auto instance = e.tryGet<InstanceComponent>();
 			if (!instance) {
 				kengine_assert_failed("Entity does not have model");
 				return;
 			}
-			const auto model = entities[instance->model];
-			const auto json = saveToJSON(model);
-			f << json.dump(4);
+			auto model = entities[instance->model];
+
+			// Lets the running autosave install its cache, so that the components it encoded are reused
+			finishAutosave(true);
+			auto & cache = model.attach<SaveCacheComponent>().cache;
+			cache = modelFileHelper::serialize(takeSnapshot(model), getSourceReferencer());
+
+			if (!modelFileHelper::writeDescription(path, cache)) {
+				kengine_assert_failed("Could not write '", path, "'");
+				return;
+			}
+			model.detach<DirtyComponent>();
+
+			std::error_code error;
+			const auto lastWrite = std::filesystem::last_write_time(path, error);
+			if (!error)
+				g_ownWrites[normalize(path)] = lastWrite;
 
 			addToRecentItems(path);
 		}
 
-		static putils::json saveToJSON(const Entity & e) noexcept {
-			putils::json ret;
+		// A model saved for the first time has no cache: all of its components are encoded
+		static modelFileHelper::SaveSnapshot takeSnapshot(Entity & model) noexcept {
+			static const modelFileHelper::SaveCache noCache;
+			const auto saveCache = model.tryGet<SaveCacheComponent>();
+			return modelFileHelper::takeSnapshot(saveCache != nullptr ? saveCache->cache : noCache, model);
+		}
 
-			const auto types = sortHelper::getNameSortedEntities<KENGINE_COMPONENT_COUNT,
-				kengine::meta::Has, kengine::meta::SaveToJSON, ::meta::ToSave
-			>();
+		// Returns false if the autosave is still running and `wait` is false
+		static bool finishAutosave(bool wait) noexcept {
+			if (!g_autosave.valid())
+				return true;
+			if (!wait && g_autosave.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				return false;
+
+			auto result = g_autosave.get();
+			if (!result.written)
+				kengine_assert_failed("Could not autosave to '", g_autosavePath, "'");
+
+			// Removed models lose their SaveCacheComponent, even if their id has been reused since
+			auto model = entities[g_autosaveModel];
+			if (const auto saveCache = model.tryGet<SaveCacheComponent>())
+				saveCache->cache = std::move(result.cache);
+			g_autosaveModel = INVALID_ID;
+			return true;
+		}
 
-			for (const auto & [_, name, has, save, toSave] : types) {
-				if (!has->call(e))
-					continue;
-				ret[name->name.c_str()] = save->call(e);
-			}
+		static void autosave(float deltaTime) noexcept {
+			if (!finishAutosave(false))
+				return;
+
+			if (g_autosaveInterval <= 0.f)
+				return;
 
-			return ret;
+			g_timeSinceAutosave += deltaTime;
+			if (g_timeSinceAutosave < g_autosaveInterval)
+				return;
+			g_timeSinceAutosave = 0.f;
+
+			const auto workspaceModel = std::find_if(g_workspace.begin(), g_workspace.end(), [](const WorkspaceModel & model) noexcept {
+				return model.instance == g_currentEntity;
+			});
+			if (g_currentEntity == INVALID_ID || workspaceModel == g_workspace.end())
+				return;
+
+			const auto instance = entities[g_currentEntity].tryGet<InstanceComponent>();
+			if (!instance)
+				return;
+
+			auto model = entities[instance->model];
+
+			// Whether the model was modified is only known once its components are serialized, so that edits made by
+			// scripts or kengine's entity editor are saved even though they don't go through dirtyHelper
+			auto snapshot = std::make_shared<modelFileHelper::SaveSnapshot>(takeSnapshot(model));
+			// Imported models have no cache until their first save, so they're always written
+			auto previous = model.attach<SaveCacheComponent>().cache;
+			g_autosaveModel = model.id;
+			g_autosavePath = getAutosavePath(workspaceModel->path);
+			g_autosave = threadPool().runTask([snapshot, previous = std::move(previous), referenceSource = getSourceReferencer(), path = g_autosavePath]() noexcept {
+				AutosaveResult ret;
+				ret.cache = modelFileHelper::serialize(std::move(*snapshot), referenceSource);
+				if (modelFileHelper::isModified(previous, ret.cache))
+					ret.written = modelFileHelper::writeDescription(path.c_str(), ret.cache);
+				else
+					ret.written = true;
+				return ret;
+			});
+		}
+
+		// "model.json" is autosaved to "model.autosave.json". Imported formats are autosaved as JSON descriptions
+		static std::string getAutosavePath(const std::string & path) noexcept {
+			std::filesystem::path ret = path;
+			const auto extension = modelFileHelper::isModelDescription(path) ? ret.extension() : std::filesystem::path(".json");
+			ret.replace_extension(".autosave");
+			ret += extension;
+			return ret.string();
+		}
+
+		// Reference the source asset rather than its cooked version. The sources are copied, as serialization may happen on the thread pool
+		static modelFileHelper::PostProcess getSourceReferencer() noexcept {
+			return [sources = g_cookedSources](const char * type, putils::json & value) noexcept {
+				if (std::string_view(type) != "ModelComponent" || !value.contains("file"))
+					return;
+
+				const auto source = sources.find(value["file"].get<std::string>());
+				if (source != sources.end())
+					value["file"] = source->second;
+			};
 		}
 	};
 
@@ -19,9 +19,11 @@
 
 #include "meta/ToSave.hpp"
 
+#include "helpers/dirtyHelper.hpp"
 #include "helpers/gizmoHelper.hpp"
 #include "helpers/instanceHelper.hpp"
 #include "helpers/typeHelper.hpp"
+#include "helpers/undoHelper.hpp"
 
 #include "imgui.h"
 #include "ImGuizmo.h"
@@ -40,7 +42,7 @@ static bool g_active = true;
 EXPORT void loadKenginePlugin(void * state) noexcept {
 	struct impl {
 		static void init() noexcept {
-			typeHelper::getTypeEntity<TransformComponent>() += meta::ToSave{};
+			typeHelper::getTypeEntity<TransformComponent>() += meta::toSave<TransformComponent>();
 			entities += [](Entity & e) {
 				e += EditorComponent{ "Transform", &g_active };
 				e += ::functions::DrawGizmos{ drawGizmos };
@@ -67,14 +69,16 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 				if (!gizmoExists)
 					gizmo.modelTransformSave = modelTransform;
 
-				gizmoHelper::drawGizmo(gizmo.transform, proj, view);
+				const auto manipulated = gizmoHelper::drawGizmo(gizmo.transform, proj, view);
+				undoHelper::trackGizmo({ model.id }, manipulated);
 
-				if (ImGuizmo::IsUsing()) {
+				if (manipulated) {
 					modelTransform.boundingBox.position = gizmo.transform.boundingBox.position + gizmo.modelTransformSave.boundingBox.position;
 					modelTransform.boundingBox.size = gizmo.transform.boundingBox.size * gizmo.modelTransformSave.boundingBox.size;
 					modelTransform.yaw = gizmo.transform.yaw + gizmo.modelTransformSave.yaw;
 					modelTransform.pitch = gizmo.transform.pitch + gizmo.modelTransformSave.pitch;
 					modelTransform.roll = gizmo.transform.roll + gizmo.modelTransformSave.roll;
+					dirtyHelper::markDirty<TransformComponent>(model);
 				}
 				else {
 					gizmo.transform = {};
@@ -18,6 +18,7 @@
 
 #include "meta/ToSave.hpp"
 
+#include "helpers/dirtyHelper.hpp"
 #include "helpers/instanceHelper.hpp"
 #include "helpers/typeHelper.hpp"
 
@@ -39,7 +40,7 @@ static bool g_openContextMenu = false;
 EXPORT void loadKenginePlugin(void * state) noexcept {
 	struct impl {
 		static void init() noexcept {
-			typeHelper::getTypeEntity<NavMeshComponent>() += meta::ToSave{};
+			typeHelper::getTypeEntity<NavMeshComponent>() += meta::toSave<NavMeshComponent>();
 
 			entities += [](Entity & e) noexcept {
 				e += EditorComponent{ "Navmesh", &g_active };
@@ -63,8 +64,12 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 				auto model = entities[instance.model];
 				auto & navMesh = model.attach<NavMeshComponent>();
 
-				if (ImGui::Begin("Navmesh"))
+				if (ImGui::Begin("Navmesh")) {
+					const auto previous = navMesh;
 					putils::reflection::imguiEdit(navMesh);
+					if (changed(previous, navMesh))
+						dirtyHelper::markDirty<NavMeshComponent>(model);
+				}
 				ImGui::End();
 
 				auto actor = entities[g_actor];
@@ -82,6 +87,14 @@ EXPORT void loadKenginePlugin(void * state) noexcept {
 			}
 		}
 
+		static bool changed(const NavMeshComponent & previous, const NavMeshComponent & current) noexcept {
+			bool ret = false;
+			putils::reflection::for_each_attribute<NavMeshComponent>([&](const auto name, const auto member) noexcept {
+				ret = ret || !(previous.*member == current.*member);
+			});
+			return ret;
+		}
+
 		static void handleActivationChange() noexcept {
 			static std::optional<bool> g_previousActive = std::nullopt;
 			const auto activeChanged = !g_previousActive || (*g_previousActive != g_active);
@@ -0,0 +1,282 @@
+#include <glm/glm.hpp>
+
+#include "kengine.hpp"
+#include "Export.hpp"
+#include "helpers/pluginHelper.hpp"
+
+#include "data/AdjustableComponent.hpp"
+#include "data/CameraComponent.hpp"
+#include "data/InstanceComponent.hpp"
+#include "data/TransformComponent.hpp"
+#include "data/ViewportComponent.hpp"
+
+#include "functions/Execute.hpp"
+#include "functions/GetEntityInPixel.hpp"
+#include "functions/GetPositionInPixel.hpp"
+#include "functions/OnEntityRemoved.hpp"
+#include "functions/OnTerminate.hpp"
+
+#include "helpers/bvhHelper.hpp"
+#include "helpers/cameraHelper.hpp"
+#include "helpers/matrixHelper.hpp"
+#include "helpers/sceneChangeHelper.hpp"
+
+#include "imgui.h"
+
+using namespace kengine;
+
+// Ray casts against the oriented bounding boxes of model instances, kept in a BVH which is refit when their transform
+// or their model's changes. Works without reading back the GBuffer, so also in headless sessions
+
+struct PickingProxyComponent {
+	int proxy = bvhHelper::Tree::NULL_NODE;
+	// As of the last refit
+	TransformComponent transform;
+	TransformComponent modelTransform;
+	glm::mat4 worldToLocal; // Maps the entity's box to [-.5, .5]
+	bool invertible = false;
+};
+
+// GPU picking functions, detached from their entity while CPU picking replaces them
+struct StashedPickingComponent {
+	std::optional<functions::GetEntityInPixel> getEntity;
+	std::optional<functions::GetPositionInPixel> getPosition;
+};
+
+struct Ray {
+	glm::vec3 origin;
+	glm::vec3 direction; // From the near to the far plane, so hits are within [0, 1]
+};
+
+struct Hit {
+	EntityID entity = INVALID_ID;
+	glm::vec3 position;
+};
+
+static bvhHelper::Tree g_tree;
+static EntityID g_id = INVALID_ID;
+
+static bool g_replaceGPUPicking = false;
+// Kengine's CameraComponent has no clipping planes, these default to the ones the gizmo context projects with
+static float g_nearPlane = 0.001f;
+static float g_farPlane = 1000.f;
+// Our results are only returned when there's no GPU picking, as they'd be used wherever it found nothing
+static bool g_gpuPickingAvailable = false;
+
+EXPORT void loadKenginePlugin(void * state) noexcept {
+	struct impl {
+		static void init() noexcept {
+			entities += [](Entity & e) noexcept {
+				g_id = e.id;
+
+				e += functions::Execute{ execute };
+				e += functions::OnTerminate{ onTerminate };
+				e += functions::OnEntityRemoved{ [](Entity & e) noexcept {
+					if (const auto proxy = e.tryGet<PickingProxyComponent>()) {
+						g_tree.remove(proxy->proxy);
+						sceneChangeHelper::markTransformsChanged();
+					}
+				} };
+				e += functions::GetEntityInPixel{ [](EntityID window, const putils::Point2f & coords) noexcept {
+					return raycast(window, coords).entity;
+				} };
+				e += functions::GetPositionInPixel{ [](EntityID window, const putils::Point2f & coords) noexcept -> std::optional<putils::Point3f> {
+					const auto hit = raycast(window, coords);
+					if (hit.entity == INVALID_ID)
+						return std::nullopt;
+					return putils::Point3f{ hit.position.x, hit.position.y, hit.position.z };
+				} };
+				e += AdjustableComponent{
+					"Picking", {
+						{ "Replace GPU picking", &g_replaceGPUPicking },
+						{ "Near plane", &g_nearPlane },
+						{ "Far plane", &g_farPlane }
+					}
+				};
+			};
+		}
+
+		static void execute(float deltaTime) noexcept {
+			refitTree();
+
+			if (g_replaceGPUPicking)
+				stashGPUPicking();
+			else
+				restoreGPUPicking();
+
+			g_gpuPickingAvailable = false;
+			for (const auto & [e, getEntity] : entities.with<functions::GetEntityInPixel>())
+				g_gpuPickingAvailable |= e.id != g_id;
+		}
+
+		// Proxies index into this module's tree, a reloaded build starts from an empty one
+		static void onTerminate() noexcept {
+			restoreGPUPicking();
+
+			std::vector<EntityID> proxies;
+			for (const auto & [e, proxy] : entities.with<PickingProxyComponent>())
+				proxies.push_back(e.id);
+			for (const auto id : proxies)
+				entities[id].detach<PickingProxyComponent>();
+		}
+
+		// Leaves of removed entities are removed by OnEntityRemoved. Systems caching picking results are told about
+		// moved instances through sceneChangeHelper, as physics and scripts move them without marking anything dirty.
+		// Kengine doesn't report modified components, so every instance's transform is compared each frame: only the
+		// refits are proportional to what moved
+		static void refitTree() noexcept {
+			static const TransformComponent identity;
+
+			bool changed = false;
+			for (auto [e, transform, instance] : entities.with<TransformComponent, InstanceComponent>()) {
+				const auto modelTransform = entities[instance.model].tryGet<TransformComponent>();
+				const auto & model = modelTransform != nullptr ? *modelTransform : identity;
+
+				const auto proxy = e.tryGet<PickingProxyComponent>();
+				if (proxy == nullptr) {
+					PickingProxyComponent newProxy;
+					const auto box = updateProxy(newProxy, transform, model);
+					newProxy.proxy = g_tree.insert(box, e.id);
+					e += newProxy;
+					changed = true;
+				}
+				else if (!sceneChangeHelper::sameTransform(proxy->transform, transform) || !sceneChangeHelper::sameTransform(proxy->modelTransform, model)) {
+					g_tree.update(proxy->proxy, updateProxy(*proxy, transform, model));
+					changed = true;
+				}
+			}
+
+			if (changed)
+				sceneChangeHelper::markTransformsChanged();
+		}
+
+		// Returns the world-space bounds of the entity's oriented box
+		static bvhHelper::AABB updateProxy(PickingProxyComponent & proxy, const TransformComponent & transform, const TransformComponent & modelTransform) noexcept {
+			proxy.transform = transform;
+			proxy.modelTransform = modelTransform;
+
+			const auto localToWorld = matrixHelper::getModelMatrix(transform, &modelTransform);
+			proxy.invertible = glm::determinant(localToWorld) != 0.f;
+			if (proxy.invertible)
+				proxy.worldToLocal = glm::inverse(localToWorld);
+
+			const glm::vec3 center = localToWorld[3];
+			glm::vec3 extent{ 0.f };
+			for (int i = 0; i < 3; ++i)
+				extent += glm::abs(glm::vec3(localToWorld[i])) * .5f;
+			return { center - extent, center + extent };
+		}
+
+		static Hit raycast(EntityID window, const putils::Point2f & coords) noexcept {
+			Hit ret;
+			if (g_gpuPickingAvailable)
+				return ret;
+
+			const auto ray = getRay(window, coords);
+			if (!ray)
+				return ret;
+
+			static const bvhHelper::AABB localBox{ glm::vec3{ -.5f }, glm::vec3{ .5f } };
+			float closest = 1.f;
+			g_tree.raycast(ray->origin, ray->direction, closest, [&](EntityID id, float maxDistance) noexcept {
+				const auto proxy = entities[id].tryGet<PickingProxyComponent>();
+				if (proxy == nullptr || !proxy->invertible)
+					return maxDistance;
+
+				// Affine, so distances along the ray are preserved
+				const glm::vec3 localOrigin = proxy->worldToLocal * glm::vec4(ray->origin, 1.f);
+				const glm::vec3 localDirection = proxy->worldToLocal * glm::vec4(ray->direction, 0.f);
+				const auto distance = bvhHelper::intersect(localBox, localOrigin, 1.f / localDirection, maxDistance);
+				if (!distance)
+					return maxDistance;
+
+				ret.entity = id;
+				closest = *distance;
+				return closest;
+			});
+
+			ret.position = ray->origin + ray->direction * closest;
+			return ret;
+		}
+
+		static std::optional<Ray> getRay(EntityID window, const putils::Point2f & coords) noexcept {
+			auto cameraID = cameraHelper::getViewportForPixel(window, coords).camera;
+			// Headless sessions have no window, the first camera is used
+			if (cameraID == INVALID_ID)
+				for (const auto & [e, cam, viewport] : entities.with<CameraComponent, ViewportComponent>()) {
+					cameraID = e.id;
+					break;
+				}
+			if (cameraID == INVALID_ID)
+				return std::nullopt;
+
+			const auto camera = entities[cameraID];
+			const auto & cam = camera.get<CameraComponent>();
+			const auto & viewport = camera.get<ViewportComponent>();
+
+			const auto & displaySize = ImGui::GetIO().DisplaySize;
+			const auto & box = viewport.boundingBox;
+			const glm::vec2 percent{
+				(coords.x / displaySize.x - box.position.x) / box.size.x,
+				(coords.y / displaySize.y - box.position.y) / box.size.y
+			};
+			if (percent.x < 0.f || percent.x > 1.f || percent.y < 0.f || percent.y > 1.f)
+				return std::nullopt;
+
+			const auto proj = matrixHelper::getProjMatrix(cam, viewport, g_nearPlane, g_farPlane);
+			const auto view = matrixHelper::getViewMatrix(cam, viewport);
+			const auto clipToWorld = glm::inverse(proj * view);
+
+			const glm::vec2 ndc{ percent.x * 2.f - 1.f, 1.f - percent.y * 2.f };
+			auto nearPoint = clipToWorld * glm::vec4(ndc, -1.f, 1.f);
+			auto farPoint = clipToWorld * glm::vec4(ndc, 1.f, 1.f);
+			nearPoint /= nearPoint.w;
+			farPoint /= farPoint.w;
+
+			return Ray{ glm::vec3(nearPoint), glm::vec3(farPoint - nearPoint) };
+		}
+
+		// Kengine iterates picking functions in entity order, so the GPU ones have to be detached for ours to be used
+		static void stashGPUPicking() noexcept {
+			std::vector<EntityID> providers;
+			for (const auto & [e, getEntity] : entities.with<functions::GetEntityInPixel>())
+				if (e.id != g_id)
+					providers.push_back(e.id);
+			for (const auto & [e, getPosition] : entities.with<functions::GetPositionInPixel>())
+				if (e.id != g_id)
+					providers.push_back(e.id);
+
+			for (const auto id : providers) {
+				auto e = entities[id];
+				auto & stashed = e.attach<StashedPickingComponent>();
+				if (const auto getEntity = e.tryGet<functions::GetEntityInPixel>()) {
+					stashed.getEntity = *getEntity;
+					e.detach<functions::GetEntityInPixel>();
+				}
+				if (const auto getPosition = e.tryGet<functions::GetPositionInPixel>()) {
+					stashed.getPosition = *getPosition;
+					e.detach<functions::GetPositionInPixel>();
+				}
+			}
+		}
+
+		static void restoreGPUPicking() noexcept {
+			std::vector<EntityID> stashedEntities;
+			for (const auto & [e, stashed] : entities.with<StashedPickingComponent>())
+				stashedEntities.push_back(e.id);
+
+			for (const auto id : stashedEntities) {
+				auto e = entities[id];
+				const auto stashed = e.get<StashedPickingComponent>();
+				if (stashed.getEntity)
+					e += *stashed.getEntity;
+				if (stashed.getPosition)
+					e += *stashed.getPosition;
+				e.detach<StashedPickingComponent>();
+			}
+		}
+	};
+
+	pluginHelper::initPlugin(state);
+	impl::init();
+}
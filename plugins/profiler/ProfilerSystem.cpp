@@ -0,0 +1,309 @@
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+
+#include "kengine.hpp"
+#include "Export.hpp"
+#include "helpers/pluginHelper.hpp"
+
+#include "data/AdjustableComponent.hpp"
+#include "data/ImGuiToolComponent.hpp"
+#include "data/NameComponent.hpp"
+#include "data/PluginComponent.hpp"
+
+#include "functions/DrawGizmos.hpp"
+#include "functions/Execute.hpp"
+#include "functions/OnTerminate.hpp"
+
+#include "helpers/assertHelper.hpp"
+#include "helpers/traceHelper.hpp"
+
+#include "imgui.h"
+#include "concat.hpp"
+
+using namespace kengine;
+using Clock = std::chrono::steady_clock;
+
+static constexpr auto TRACE_FILE = "profile.json";
+
+struct Label {
+	std::string name;
+	std::string category;
+};
+
+// Timing of one call to a profiled function
+struct ProfileEvent {
+	std::uint32_t label;
+	std::uint32_t depth; // Number of profiled calls this one is nested in
+	std::uint64_t frame;
+	std::int64_t startNs; // Since g_origin
+	std::int64_t durationNs;
+};
+
+// Original functions of profiled entities, called by the timing wrappers that replaced them
+struct ProfiledExecute {
+	kengine::functions::Execute original;
+	std::uint32_t label = 0;
+};
+
+struct ProfiledDrawGizmos {
+	::functions::DrawGizmos original;
+	std::uint32_t label = 0;
+};
+
+static const auto g_origin = Clock::now();
+
+static std::vector<Label> g_labels;
+static std::unordered_map<std::string, std::uint32_t> g_labelIndices;
+
+// Ring buffer of events, the latest one is at (g_eventCount - 1) % size
+static std::vector<ProfileEvent> g_events;
+static size_t g_eventCount = 0;
+
+static std::uint64_t g_frame = 0;
+static std::uint32_t g_depth = 0;
+
+static EntityID g_id = INVALID_ID;
+static bool g_paused = false;
+static std::uint64_t g_displayedFrame = 0;
+
+static int g_bufferSize = 1 << 17;
+static float g_dumpSeconds = 10.f;
+
+template<typename Func, typename ... Args>
+static void profile(std::uint32_t label, const Func & func, Args && ... args) noexcept {
+	const auto depth = g_depth++;
+	const auto start = Clock::now();
+	func(std::forward<Args>(args)...);
+	const auto end = Clock::now();
+	--g_depth;
+
+	if (g_paused || g_events.empty())
+		return;
+
+	auto & event = g_events[g_eventCount % g_events.size()];
+	event.label = label;
+	event.depth = depth;
+	event.frame = g_frame;
+	event.startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - g_origin).count();
+	event.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	++g_eventCount;
+}
+
+// Calls `func` on the buffered events, from the latest to the oldest, until it returns false
+template<typename Func>
+static void forEachEventBackwards(Func && func) noexcept {
+	const auto count = std::min(g_eventCount, g_events.size());
+	for (size_t i = 0; i < count; ++i)
+		if (!func(g_events[(g_eventCount - 1 - i) % g_events.size()]))
+			return;
+}
+
+EXPORT void loadKenginePlugin(void * state) noexcept {
+	struct impl {
+		static void init() noexcept {
+			entities += [](Entity & e) noexcept {
+				g_id = e.id;
+				e += NameComponent{ "Profiler" };
+				e += ImGuiToolComponent{};
+				e += kengine::functions::Execute{ execute };
+				e += kengine::functions::OnTerminate{ unwrapFunctions };
+				e += ProfiledExecute{}; // Don't profile the profiler
+				e += AdjustableComponent{
+					"Profiler", {
+						{ "Buffered events", &g_bufferSize },
+						{ "Dumped seconds", &g_dumpSeconds }
+					}
+				};
+			};
+		}
+
+		static void execute(float deltaTime) noexcept {
+			if (!g_paused)
+				g_displayedFrame = g_frame;
+			++g_frame;
+
+			if (g_bufferSize > 0 && g_events.size() != (size_t)g_bufferSize) {
+				g_events.assign(g_bufferSize, ProfileEvent{});
+				g_eventCount = 0;
+			}
+
+			wrapNewFunctions();
+
+			auto & tool = entities[g_id].get<ImGuiToolComponent>();
+			if (!tool.enabled)
+				return;
+
+			if (ImGui::Begin("Profiler", &tool.enabled)) {
+				ImGui::Checkbox("Pause", &g_paused);
+				ImGui::SameLine();
+				if (ImGui::Button(putils::concat("Dump last ", g_dumpSeconds, " seconds").c_str()))
+					dump();
+				drawFrame(g_displayedFrame);
+			}
+			ImGui::End();
+		}
+
+		static void wrapNewFunctions() noexcept {
+			for (auto [e, execute, noProfiled] : entities.with<kengine::functions::Execute, no<ProfiledExecute>>()) {
+				e += ProfiledExecute{ execute, getLabel(e, "Execute") };
+				execute.func = [id = e.id](float deltaTime) noexcept {
+					const auto & profiled = entities[id].get<ProfiledExecute>();
+					profile(profiled.label, profiled.original, deltaTime);
+				};
+			}
+
+			for (auto [e, drawGizmos, noProfiled] : entities.with<::functions::DrawGizmos, no<ProfiledDrawGizmos>>()) {
+				e += ProfiledDrawGizmos{ drawGizmos, getLabel(e, "DrawGizmos") };
+				drawGizmos.func = [id = e.id](const glm::mat4 & proj, const glm::mat4 & view, const ImVec2 & windowSize, const ImVec2 & windowPos) noexcept {
+					const auto & profiled = entities[id].get<ProfiledDrawGizmos>();
+					profile(profiled.label, profiled.original, proj, view, windowSize, windowPos);
+				};
+			}
+		}
+
+		// The wrappers call into this module, so the original functions are given back when it is unloaded
+		static void unwrapFunctions() noexcept {
+			std::vector<EntityID> wrapped;
+			for (auto [e, execute, profiled] : entities.with<kengine::functions::Execute, ProfiledExecute>()) {
+				if (e.id != g_id)
+					execute = profiled.original;
+				wrapped.push_back(e.id);
+			}
+			for (const auto id : wrapped)
+				entities[id].detach<ProfiledExecute>();
+
+			wrapped.clear();
+			for (auto [e, drawGizmos, profiled] : entities.with<::functions::DrawGizmos, ProfiledDrawGizmos>()) {
+				drawGizmos = profiled.original;
+				wrapped.push_back(e.id);
+			}
+			for (const auto id : wrapped)
+				entities[id].detach<ProfiledDrawGizmos>();
+		}
+
+		static std::uint32_t getLabel(const Entity & e, const char * category) noexcept {
+			const auto plugin = e.tryGet<PluginComponent>();
+			auto name = plugin != nullptr ? plugin->name : putils::concat("Entity ", e.id);
+			if (std::string_view(category) != "Execute")
+				name += putils::concat(" (", category, ")");
+
+			const auto it = g_labelIndices.find(name);
+			if (it != g_labelIndices.end())
+				return it->second;
+
+			const auto index = (std::uint32_t)g_labels.size();
+			g_labelIndices[name] = index;
+			g_labels.push_back({ std::move(name), category });
+			return index;
+		}
+
+		static void drawFrame(std::uint64_t frame) noexcept {
+			std::vector<ProfileEvent> events;
+			forEachEventBackwards([&](const ProfileEvent & event) noexcept {
+				if (event.frame > frame)
+					return true;
+				if (event.frame < frame)
+					return false;
+				events.push_back(event);
+				return true;
+			});
+
+			if (events.empty()) {
+				ImGui::Text("No events recorded");
+				return;
+			}
+
+			auto frameStart = events.front().startNs;
+			auto frameEnd = events.front().startNs + events.front().durationNs;
+			std::uint32_t maxDepth = 0;
+			for (const auto & event : events) {
+				frameStart = std::min(frameStart, event.startNs);
+				frameEnd = std::max(frameEnd, event.startNs + event.durationNs);
+				maxDepth = std::max(maxDepth, event.depth);
+			}
+			const auto frameDuration = (float)std::max<std::int64_t>(frameEnd - frameStart, 1);
+
+			ImGui::Text("Frame %llu: %.3f ms", (unsigned long long)frame, frameDuration / 1'000'000.f);
+
+			drawFlameGraph(events, frameStart, frameDuration, maxDepth);
+			drawTotals(events);
+		}
+
+		static void drawFlameGraph(const std::vector<ProfileEvent> & events, std::int64_t frameStart, float frameDuration, std::uint32_t maxDepth) noexcept {
+			const auto drawList = ImGui::GetWindowDrawList();
+			const auto origin = ImGui::GetCursorScreenPos();
+			const auto width = std::max(ImGui::GetContentRegionAvail().x, 1.f);
+			const auto rowHeight = ImGui::GetTextLineHeightWithSpacing();
+
+			for (const auto & event : events) {
+				const ImVec2 min{
+					origin.x + (float)(event.startNs - frameStart) / frameDuration * width,
+					origin.y + (float)event.depth * rowHeight
+				};
+				const ImVec2 max{
+					std::max(min.x + (float)event.durationNs / frameDuration * width, min.x + 1.f),
+					min.y + rowHeight - 1.f
+				};
+
+				const auto & label = g_labels[event.label];
+				drawList->AddRectFilled(min, max, ImColor::HSV((float)(event.label % 16) / 16.f, .5f, .7f));
+
+				drawList->PushClipRect(min, max, true);
+				drawList->AddText({ min.x + 2.f, min.y }, IM_COL32_WHITE, label.name.c_str());
+				drawList->PopClipRect();
+
+				if (ImGui::IsMouseHoveringRect(min, max))
+					ImGui::SetTooltip("%s: %.3f ms", label.name.c_str(), (float)event.durationNs / 1'000'000.f);
+			}
+
+			ImGui::Dummy({ width, (float)(maxDepth + 1) * rowHeight });
+		}
+
+		static void drawTotals(const std::vector<ProfileEvent> & events) noexcept {
+			std::vector<std::pair<std::uint32_t, std::int64_t>> totals;
+			for (const auto & event : events) {
+				const auto it = std::find_if(totals.begin(), totals.end(), [&](const auto & total) noexcept { return total.first == event.label; });
+				if (it != totals.end())
+					it->second += event.durationNs;
+				else
+					totals.emplace_back(event.label, event.durationNs);
+			}
+
+			std::sort(totals.begin(), totals.end(), [](const auto & lhs, const auto & rhs) noexcept { return lhs.second > rhs.second; });
+
+			ImGui::Columns(2);
+			for (const auto & [label, duration] : totals) {
+				ImGui::Text("%s", g_labels[label].name.c_str());
+				ImGui::NextColumn();
+				ImGui::Text("%.3f ms", (float)duration / 1'000'000.f);
+				ImGui::NextColumn();
+			}
+			ImGui::Columns();
+		}
+
+		static void dump() noexcept {
+			const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - g_origin).count();
+			const auto first = now - (std::int64_t)(g_dumpSeconds * 1'000'000'000.f);
+
+			std::vector<traceHelper::Event> events;
+			forEachEventBackwards([&](const ProfileEvent & event) noexcept {
+				if (event.startNs < first)
+					return false;
+
+				const auto & label = g_labels[event.label];
+				events.push_back({ label.name, label.category, (double)event.startNs / 1000.0, (double)event.durationNs / 1000.0 });
+				return true;
+			});
+			std::reverse(events.begin(), events.end());
+
+			if (!traceHelper::write(TRACE_FILE, events))
+				kengine_assert_failed("Could not write '", TRACE_FILE, "'");
+		}
+	};
+
+	pluginHelper::initPlugin(state);
+	impl::init();
+}
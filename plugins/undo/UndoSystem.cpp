@@ -0,0 +1,74 @@
+#include <GLFW/glfw3.h>
+#include "kengine.hpp"
+#include "Export.hpp"
+#include "helpers/pluginHelper.hpp"
+
+#include "data/AdjustableComponent.hpp"
+#include "data/ImGuiMainMenuBarItemComponent.hpp"
+#include "data/InputComponent.hpp"
+#include "data/UndoJournalComponent.hpp"
+
+#include "functions/Execute.hpp"
+
+#include "helpers/undoHelper.hpp"
+
+#include "imgui.h"
+
+using namespace kengine;
+
+static EntityID g_id = INVALID_ID;
+
+// Each delta takes a few dozen bytes, a gizmo drag records at most one per transform field
+static int g_historySize = 65536;
+
+EXPORT void loadKenginePlugin(void * state) noexcept {
+	struct impl {
+		static void init() noexcept {
+			entities += [](Entity & e) noexcept {
+				g_id = e.id;
+
+				UndoJournalComponent journal;
+				undoHelper::reset(journal, g_historySize);
+				e += std::move(journal);
+
+				e += functions::Execute{ execute };
+				e += InputComponent{ .onKey = onKey };
+				e += AdjustableComponent{
+					"Undo", {
+						{ "History size (deltas)", &g_historySize }
+					}
+				};
+			};
+
+			entities += [](Entity & e) noexcept {
+				e += ImGuiMainMenuBarItemComponent{ "Edit", "Undo", []() noexcept {
+					if (ImGui::MenuItem("Undo", "Ctrl+Z", false, undoHelper::canUndo()))
+						undoHelper::undo();
+					if (ImGui::MenuItem("Redo", "Ctrl+Y", false, undoHelper::canRedo()))
+						undoHelper::redo();
+				} };
+			};
+		}
+
+		static void execute(float deltaTime) noexcept {
+			auto & journal = entities[g_id].get<UndoJournalComponent>();
+			const auto capacity = std::max((size_t)std::max(g_historySize, 0), UndoJournalComponent::TRANSFORM_FIELD_COUNT);
+			if (journal.capacity != capacity)
+				undoHelper::reset(journal, capacity);
+		}
+
+		static void onKey(EntityID window, int key, bool pressed) noexcept {
+			const auto & io = ImGui::GetIO();
+			if (!pressed || !io.KeyCtrl || io.WantCaptureKeyboard)
+				return;
+
+			if (key == GLFW_KEY_Z && !io.KeyShift)
+				undoHelper::undo();
+			else if (key == GLFW_KEY_Y || (key == GLFW_KEY_Z && io.KeyShift))
+				undoHelper::redo();
+		}
+	};
+
+	pluginHelper::initPlugin(state);
+	impl::init();
+}
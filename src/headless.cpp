@@ -0,0 +1,48 @@
+#include "headless.hpp"
+
+#include <algorithm>
+
+#include "kengine.hpp"
+#include "data/ImGuiContextComponent.hpp"
+#include "functions/Execute.hpp"
+
+#include "imgui.h"
+
+static size_t g_frames = 0;
+static size_t g_frame = 0;
+
+void initHeadless(size_t frames) noexcept {
+	g_frames = frames;
+	const auto context = ImGui::CreateContext();
+
+	auto & io = ImGui::GetIO();
+	io.DisplaySize = { 1280.f, 720.f };
+	io.IniFilename = nullptr;
+
+	// Fonts are normally built by the renderer's backend
+	unsigned char * pixels;
+	int width, height;
+	io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+	// Executes called before the first frame's end draw into this one
+	io.DeltaTime = 1.f / 60.f;
+	ImGui::NewFrame();
+
+	// Picked up by pluginHelper::initPlugin
+	kengine::entities += [&](kengine::Entity & e) noexcept {
+		e += kengine::ImGuiContextComponent{ context };
+
+		// Ends the ImGui frame and starts the next one, as the renderer would
+		e += kengine::functions::Execute{ [](float deltaTime) noexcept {
+			ImGui::Render();
+
+			// ImGui asserts on a null delta
+			ImGui::GetIO().DeltaTime = std::max(deltaTime, 1.f / 1000.f);
+			ImGui::NewFrame();
+
+			++g_frame;
+			if (g_frames != 0 && g_frame >= g_frames)
+				kengine::stopRunning();
+		} };
+	};
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+
+// Creates the ImGui context normally set up by the windowing systems, so that plugins can keep drawing into it without a window.
+// The frames are then run by kengine's main loop, until kengine::stopRunning is called or, if `frames` isn't 0, for `frames` frames
+void initHeadless(size_t frames) noexcept;
@@ -1,11 +1,19 @@
 #include <thread>
+#include <iostream>
+#include <string>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
 
 #include "go_to_bin_dir.hpp"
-#include "PluginManager.hpp"
 #include "kengine.hpp"
 
+#include "pluginLoader.hpp"
+#include "headless.hpp"
+
 #include "helpers/mainLoop.hpp"
 #include "helpers/imguiLuaHelper.hpp"
+#include "helpers/traceHelper.hpp"
 
 #include "systems/input/InputSystem.hpp"
 #include "systems/lua/LuaSystem.hpp"
@@ -34,54 +42,132 @@
 #include "data/WindowComponent.hpp"
 #include "data/LuaComponent.hpp"
 #include "data/PythonComponent.hpp"
+#include "data/PluginComponent.hpp"
+
+static constexpr auto STARTUP_TRACE_FILE = "startup.json";
+
+struct Options {
+	bool headless = false; // No window, GL or input backend, for batch processing and benchmarks
+	size_t frames = 0; // Frames to run in headless mode, 0 to run until kengine::stopRunning is called
+	std::string script; // Lua or Python script run every frame, which calls stopRunning once it's done
+};
+
+static void printUsage(const char * exe) noexcept {
+	std::cerr << "Usage: " << exe << " [--headless [--frames <count>]] [--script <file.lua|file.py>]" << std::endl;
+}
+
+static std::optional<Options> parseOptions(int ac, char ** av) noexcept {
+	Options options;
+
+	for (int i = 1; i < ac; ++i) {
+		const std::string_view arg = av[i];
+		const auto hasValue = i + 1 < ac;
+
+		if (arg == "--headless")
+			options.headless = true;
+		else if (arg == "--frames" && hasValue)
+			options.frames = (size_t)std::max(std::atoi(av[++i]), 0);
+		else if (arg == "--script" && hasValue)
+			options.script = std::filesystem::absolute(av[++i]).string();
+		else
+			return std::nullopt;
+	}
+
+	if (options.frames > 0 && !options.headless)
+		return std::nullopt;
+
+	return options;
+}
+
+// Times the system's creation and names its entity after it, so it can be told apart from the plugins' entities
+#define ADD_SYSTEM(SYSTEM) \
+	startup.measure(#SYSTEM, "System", [] { \
+		auto e = kengine::entities += kengine::SYSTEM(); \
+		e += PluginComponent{ #SYSTEM }; \
+	})
+
+int main(int ac, char **av) {
+	traceHelper::Recorder startup;
+
+	// Parsed before moving to the binary's directory, as the script's path may be relative
+	const auto options = parseOptions(ac, av);
+	if (!options) {
+		printUsage(av[0]);
+		return 1;
+	}
 
-int main(int, char **av) {
 	putils::goToBinDir(av[0]);
 
 #if defined(_WIN32) && defined(KENGINE_NDEBUG)
-	ShowWindow(GetConsoleWindow(), SW_HIDE);
+	if (!options->headless)
+		ShowWindow(GetConsoleWindow(), SW_HIDE);
 #endif
 
-	kengine::init(std::thread::hardware_concurrency());
-
-	extern void registerTypes() noexcept;
-	registerTypes();
-
-	kengine::entities += [](kengine::Entity & e) noexcept {
-		e += kengine::WindowComponent{
-			"Kengine Editor"
+	startup.measure("kengine::init", "Phase", [] {
+		kengine::init(std::thread::hardware_concurrency());
+	});
+
+	extern void registerTypes(traceHelper::Recorder * recorder) noexcept;
+	startup.measure("registerTypes", "Phase", [&] {
+		registerTypes(&startup);
+	});
+
+	if (options->headless)
+		initHeadless(options->frames);
+	else
+		kengine::entities += [](kengine::Entity & e) noexcept {
+			e += kengine::WindowComponent{
+				"Kengine Editor"
+			};
 		};
-	};
 
-	kengine::entities += kengine::InputSystem();
-	kengine::entities += kengine::LuaSystem();
-	kengine::entities += kengine::PythonSystem();
+	ADD_SYSTEM(InputSystem);
+	ADD_SYSTEM(LuaSystem);
+	ADD_SYSTEM(PythonSystem);
 	
-	kengine::entities += kengine::OnClickSystem();
-	kengine::entities += kengine::ModelCreatorSystem();
-
-	kengine::entities += kengine::OpenGLSystem();
-	kengine::entities += kengine::GLFWSystem();
-	kengine::entities += kengine::OpenGLSpritesSystem();
-	kengine::entities += kengine::PolyVoxSystem();
-	kengine::entities += kengine::MagicaVoxelSystem();
-	kengine::entities += kengine::AssImpSystem();
-
-	kengine::entities += kengine::BulletSystem();
-	kengine::entities += kengine::KinematicSystem();
-	kengine::entities += kengine::RecastSystem();
-
-	kengine::entities += kengine::ImGuiAdjustableSystem();
-	kengine::entities += kengine::ImGuiEngineStatsSystem();
-	kengine::entities += kengine::ImGuiToolSystem();
-	kengine::entities += kengine::ImGuiEntityEditorSystem();
-	kengine::entities += kengine::ImGuiEntitySelectorSystem();
-	kengine::entities += kengine::ImGuiPromptSystem();
-
-	putils::PluginManager pm;
-	pm.rescanDirectory("plugins", "loadKenginePlugin", kengine::getState());
-
-	kengine::imguiLuaHelper::initBindings();
+	ADD_SYSTEM(OnClickSystem);
+	ADD_SYSTEM(ModelCreatorSystem);
+
+	if (!options->headless) {
+		ADD_SYSTEM(OpenGLSystem);
+		ADD_SYSTEM(GLFWSystem);
+		ADD_SYSTEM(OpenGLSpritesSystem);
+	}
+	ADD_SYSTEM(PolyVoxSystem);
+	ADD_SYSTEM(MagicaVoxelSystem);
+	ADD_SYSTEM(AssImpSystem);
+
+	ADD_SYSTEM(BulletSystem);
+	ADD_SYSTEM(KinematicSystem);
+	ADD_SYSTEM(RecastSystem);
+
+	ADD_SYSTEM(ImGuiAdjustableSystem);
+	ADD_SYSTEM(ImGuiEngineStatsSystem);
+	ADD_SYSTEM(ImGuiToolSystem);
+	ADD_SYSTEM(ImGuiEntityEditorSystem);
+	ADD_SYSTEM(ImGuiEntitySelectorSystem);
+	ADD_SYSTEM(ImGuiPromptSystem);
+
+	startup.measure("loadPlugins", "Phase", [&] {
+		loadPlugins("plugins", &startup);
+	});
+
+	startup.measure("imguiLuaHelper::initBindings", "Phase", [] {
+		kengine::imguiLuaHelper::initBindings();
+	});
+
+	const auto events = startup.getEvents();
+	traceHelper::write(STARTUP_TRACE_FILE, events);
+	std::cout << "Slowest startup steps (full trace in " << STARTUP_TRACE_FILE << "):" << std::endl;
+	traceHelper::writeSummary(std::cout, events, 10, "Phase");
+
+	if (!options->script.empty())
+		kengine::entities += [&](kengine::Entity & e) noexcept {
+			if (std::filesystem::path(options->script).extension() == ".py")
+				e += kengine::PythonComponent{ { options->script.c_str() } };
+			else
+				e += kengine::LuaComponent{ { options->script.c_str() } };
+		};
 
 	kengine::mainLoop::timeModulated::run();
 
@@ -0,0 +1,408 @@
+#include "pluginLoader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <dlfcn.h>
+# include <unistd.h>
+#endif
+
+#include "kengine.hpp"
+#include "data/EditorComponent.hpp"
+#include "data/NameComponent.hpp"
+#include "data/PluginComponent.hpp"
+#include "data/WatchedFilesComponent.hpp"
+#include "functions/Execute.hpp"
+#include "functions/OnTerminate.hpp"
+#include "meta/SaveToJSON.hpp"
+#include "meta/ToSave.hpp"
+
+#include "json.hpp"
+
+#ifdef _WIN32
+static constexpr auto PLUGIN_EXTENSION = ".dll";
+#elif defined(__APPLE__)
+static constexpr auto PLUGIN_EXTENSION = ".dylib";
+#else
+static constexpr auto PLUGIN_EXTENSION = ".so";
+#endif
+
+// Called on the main thread, plugins create their entities here
+static constexpr auto LOAD_FUNCTION = "loadKenginePlugin";
+using LoadFunction = void(*)(void * state);
+
+// Optional, called on the thread pool while other plugins are being loaded. Must not touch the entity pools
+static constexpr auto PREPARE_FUNCTION = "prepareKenginePlugin";
+using PrepareFunction = void(*)(void * state);
+
+// Plugins stay loaded until the process exits, as their code backs the functions attached to entities.
+// This includes the previous builds of hot-reloaded plugins, as components and functions they created may outlive their entities
+#ifdef _WIN32
+static std::vector<HMODULE> g_libraries;
+#else
+static std::vector<void *> g_libraries;
+#endif
+static std::mutex g_librariesMutex;
+
+// Modules are loaded from copies in this directory, so that the originals can be overwritten when they are rebuilt
+static std::filesystem::path g_shadowDirectory;
+static std::atomic<size_t> g_shadowCount = 0;
+
+struct Plugin {
+	std::filesystem::path path;
+	std::string name;
+	LoadFunction load = nullptr;
+	PrepareFunction prepare = nullptr;
+};
+
+// Read from "<name>.manifest.json" next to the module, so that lazy plugins can be presented without being loaded
+struct Manifest {
+	bool lazy = false; // Only loaded once one of its editors is activated, so its editors start inactive whatever the plugin's own default
+	std::vector<std::string> editors; // Names of the plugin's EditorComponents
+	std::vector<std::string> toSave; // Component types the plugin tags with meta::ToSave
+};
+
+// Plugin whose editors are stood in for by placeholder EditorComponents until one of them is activated
+struct LazyPlugin {
+	std::filesystem::path path;
+	std::string name;
+	std::vector<kengine::EntityID> placeholders;
+	std::vector<std::unique_ptr<bool>> active; // Pointed to by the placeholders' EditorComponents
+};
+static std::vector<LazyPlugin> g_lazyPlugins;
+
+// Loaded plugins, reloaded when their module changes on disk
+struct LoadedPlugin {
+	std::string path; // Absolute and normalized, as reported by the file watcher
+	std::string name;
+};
+static std::vector<LoadedPlugin> g_loadedPlugins;
+static std::vector<std::string> g_changedPlugins;
+
+// New build of a changed plugin, copied and opened on the thread pool
+struct PendingReload {
+	LoadedPlugin loaded;
+	std::future<Plugin> plugin;
+};
+static std::vector<PendingReload> g_pendingReloads;
+static kengine::EntityID g_loaderID = kengine::INVALID_ID;
+
+static std::string getPluginName(const std::filesystem::path & path) noexcept {
+	// "libmodelLoader.so" is named "modelLoader"
+	auto name = path.stem().string();
+	if (name.starts_with("lib"))
+		name = name.substr(3);
+	return name;
+}
+
+static std::unordered_set<kengine::EntityID> getEntities() noexcept {
+	std::unordered_set<kengine::EntityID> ret;
+	for (const auto e : kengine::entities)
+		ret.insert(e.id);
+	return ret;
+}
+
+// Tags the entities which don't appear in `previousEntities`
+static void tagNewEntities(const std::string & pluginName, const std::unordered_set<kengine::EntityID> & previousEntities) noexcept {
+	for (auto e : kengine::entities)
+		if (!previousEntities.contains(e.id) && !e.has<PluginComponent>())
+			e += PluginComponent{ pluginName };
+}
+
+static std::filesystem::path getShadowDirectory(const std::filesystem::path & directory) noexcept {
+#ifdef _WIN32
+	const auto pid = GetCurrentProcessId();
+#else
+	const auto pid = getpid();
+#endif
+	// Copies left over by previous runs are cleared. Those still loaded by another instance are either locked or safe to unlink
+	const auto root = directory / ".shadow";
+	std::error_code error;
+	std::filesystem::remove_all(root, error);
+
+	const auto ret = root / std::to_string(pid);
+	std::filesystem::create_directories(ret, error);
+	if (error)
+		std::cerr << "Failed to create '" << ret.string() << "', plugins won't be hot-reloadable: " << error.message() << std::endl;
+	return ret;
+}
+
+// Safe to call from any thread
+static void openPlugin(const std::filesystem::path & path, Plugin & plugin) noexcept {
+	// Each copy is given a new name, as dlopen would return the previous build if given the same path
+	auto loadedPath = path;
+	if (!g_shadowDirectory.empty()) {
+		const auto shadowPath = g_shadowDirectory / (path.stem().string() + '.' + std::to_string(g_shadowCount++) + path.extension().string());
+		std::error_code error;
+		if (std::filesystem::copy_file(path, shadowPath, std::filesystem::copy_options::overwrite_existing, error))
+			loadedPath = shadowPath;
+		else
+			std::cerr << "Failed to copy plugin '" << path.string() << "', it won't be hot-reloadable: " << error.message() << std::endl;
+	}
+
+#ifdef _WIN32
+	const auto library = LoadLibraryA(loadedPath.string().c_str());
+	if (library == nullptr) {
+		std::cerr << "Failed to load plugin '" << path.string() << "': error " << GetLastError() << std::endl;
+		return;
+	}
+	plugin.load = (LoadFunction)GetProcAddress(library, LOAD_FUNCTION);
+	plugin.prepare = (PrepareFunction)GetProcAddress(library, PREPARE_FUNCTION);
+#else
+	const auto library = dlopen(loadedPath.string().c_str(), RTLD_NOW);
+	if (library == nullptr) {
+		std::cerr << "Failed to load plugin '" << path.string() << "': " << dlerror() << std::endl;
+		return;
+	}
+	plugin.load = (LoadFunction)dlsym(library, LOAD_FUNCTION);
+	plugin.prepare = (PrepareFunction)dlsym(library, PREPARE_FUNCTION);
+#endif
+
+	const std::lock_guard lock(g_librariesMutex);
+	g_libraries.push_back(library);
+}
+
+static Manifest readManifest(const std::filesystem::path & path) noexcept {
+	Manifest ret;
+
+	const auto manifestPath = path.parent_path() / (getPluginName(path) + ".manifest.json");
+	std::ifstream f(manifestPath);
+	if (!f)
+		return ret;
+
+	const auto json = putils::json::parse(f, nullptr, false);
+	if (json.is_discarded() || !json.is_object()) {
+		std::cerr << "Invalid plugin manifest '" << manifestPath.string() << "'" << std::endl;
+		return ret;
+	}
+
+	ret.lazy = json.value("lazy", false);
+	ret.editors = json.value("editors", std::vector<std::string>{});
+	ret.toSave = json.value("toSave", std::vector<std::string>{});
+	return ret;
+}
+
+static void watchPlugin(const Plugin & plugin) noexcept {
+	std::error_code error;
+	const auto path = std::filesystem::absolute(plugin.path, error).lexically_normal().string();
+	const bool alreadyWatched = std::any_of(g_loadedPlugins.begin(), g_loadedPlugins.end(), [&](const LoadedPlugin & loaded) noexcept {
+		return loaded.path == path;
+	});
+	if (alreadyWatched)
+		return;
+
+	g_loadedPlugins.push_back(LoadedPlugin{ path, plugin.name });
+	kengine::entities[g_loaderID].get<WatchedFilesComponent>().files.push_back(path);
+}
+
+static void loadPlugin(const Plugin & plugin) noexcept {
+	const auto previousEntities = getEntities();
+	plugin.load(kengine::getState());
+	tagNewEntities(plugin.name, previousEntities);
+	watchPlugin(plugin);
+}
+
+static void activateEditors(const std::vector<std::string> & editorNames) noexcept {
+	for (const auto & [e, editor] : kengine::entities.with<EditorComponent>())
+		if (std::find(editorNames.begin(), editorNames.end(), editor.name) != editorNames.end())
+			*editor.active = true;
+}
+
+// Removes the plugin's entities and returns the names of its active editors
+static std::vector<std::string> unloadPlugin(const std::string & name) noexcept {
+	std::vector<kengine::EntityID> toRemove;
+	for (const auto & [e, plugin] : kengine::entities.with<PluginComponent>())
+		if (plugin.name == name)
+			toRemove.push_back(e.id);
+
+	std::vector<std::string> activeEditors;
+	for (const auto id : toRemove) {
+		auto e = kengine::entities[id];
+		if (const auto onTerminate = e.tryGet<kengine::functions::OnTerminate>())
+			(*onTerminate)();
+		if (const auto editor = e.tryGet<EditorComponent>())
+			if (*editor->active)
+				activeEditors.push_back(editor->name);
+	}
+
+	for (const auto id : toRemove)
+		kengine::entities -= id;
+
+	return activeEditors;
+}
+
+// The new build is opened first, so the previous one is kept if it's incomplete
+static void reloadPlugin(const LoadedPlugin & loaded, const Plugin & plugin) noexcept {
+	if (plugin.load == nullptr) {
+		std::cerr << "Keeping the previous build of plugin '" << loaded.name << "'" << std::endl;
+		return;
+	}
+
+	std::cout << "Reloading plugin '" << loaded.name << "'" << std::endl;
+	const auto activeEditors = unloadPlugin(loaded.name);
+	// Only initializes the new module's own state, and must see what the previous build saved when it was terminated
+	if (plugin.prepare != nullptr)
+		plugin.prepare(kengine::getState());
+	loadPlugin(plugin);
+	activateEditors(activeEditors);
+}
+
+static void reloadChangedPlugins() noexcept {
+	for (const auto & path : g_changedPlugins) {
+		const auto it = std::find_if(g_loadedPlugins.begin(), g_loadedPlugins.end(), [&](const LoadedPlugin & loaded) noexcept {
+			return loaded.path == path;
+		});
+		if (it != g_loadedPlugins.end())
+			g_pendingReloads.push_back({ *it, kengine::threadPool().runTask([loaded = *it]() noexcept {
+				Plugin plugin{ loaded.path, loaded.name };
+				openPlugin(loaded.path, plugin);
+				return plugin;
+			}) });
+	}
+	g_changedPlugins.clear();
+
+	// Reloaded in the order their modules changed
+	while (!g_pendingReloads.empty() && g_pendingReloads.front().plugin.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		auto reload = std::move(g_pendingReloads.front());
+		g_pendingReloads.erase(g_pendingReloads.begin());
+		reloadPlugin(reload.loaded, reload.plugin.get());
+	}
+}
+
+static void loadLazyPlugin(LazyPlugin & lazyPlugin) noexcept {
+	std::vector<std::string> activeEditors;
+	for (size_t i = 0; i < lazyPlugin.placeholders.size(); ++i) {
+		const auto placeholder = kengine::entities[lazyPlugin.placeholders[i]];
+		if (*lazyPlugin.active[i])
+			activeEditors.push_back(placeholder.get<EditorComponent>().name);
+		kengine::entities -= placeholder;
+	}
+	lazyPlugin.placeholders.clear();
+
+	Plugin plugin{ lazyPlugin.path, lazyPlugin.name };
+	openPlugin(lazyPlugin.path, plugin);
+	if (plugin.load == nullptr)
+		return;
+
+	if (plugin.prepare != nullptr)
+		plugin.prepare(kengine::getState());
+	loadPlugin(plugin);
+
+	// Hand the activation over to the plugin's own editors
+	activateEditors(activeEditors);
+}
+
+static void loadActivatedPlugins() noexcept {
+	for (auto & lazyPlugin : g_lazyPlugins) {
+		if (lazyPlugin.placeholders.empty())
+			continue;
+
+		const bool activated = std::any_of(lazyPlugin.active.begin(), lazyPlugin.active.end(), [](const auto & active) noexcept {
+			return *active;
+		});
+		if (activated)
+			loadLazyPlugin(lazyPlugin);
+	}
+}
+
+static void addLazyPlugin(const std::filesystem::path & path, const Manifest & manifest) noexcept {
+	// Components saved by the plugin must be saved even if it never gets loaded
+	for (auto [type, name, save] : kengine::entities.with<kengine::NameComponent, kengine::meta::SaveToJSON>())
+		if (!type.has<::meta::ToSave>() && std::find(manifest.toSave.begin(), manifest.toSave.end(), name.name.c_str()) != manifest.toSave.end())
+			type += ::meta::ToSave{};
+
+	auto & lazyPlugin = g_lazyPlugins.emplace_back();
+	lazyPlugin.path = path;
+	lazyPlugin.name = getPluginName(path);
+
+	// Placeholders start inactive, as an active one would load the plugin right away
+	for (const auto & editorName : manifest.editors) {
+		auto & active = lazyPlugin.active.emplace_back(std::make_unique<bool>(false));
+		const auto placeholder = kengine::entities += [&](kengine::Entity & e) noexcept {
+			e += EditorComponent{ editorName, active.get() };
+			e += PluginComponent{ lazyPlugin.name };
+		};
+		lazyPlugin.placeholders.push_back(placeholder.id);
+	}
+}
+
+void loadPlugins(const char * directory, traceHelper::Recorder * recorder) noexcept {
+	const auto measure = [&](const std::string & name, const char * category, auto && func) noexcept {
+		if (recorder != nullptr)
+			recorder->measure(name, category, func);
+		else
+			func();
+	};
+
+	// Sorted so that plugins are always registered in the same order
+	std::vector<std::filesystem::path> paths;
+	std::error_code error;
+	for (const auto & entry : std::filesystem::directory_iterator(directory, error))
+		if (entry.is_regular_file(error) && entry.path().extension() == PLUGIN_EXTENSION)
+			paths.push_back(entry.path());
+	std::sort(paths.begin(), paths.end());
+
+	g_shadowDirectory = getShadowDirectory(directory);
+
+	std::vector<std::filesystem::path> lazyPaths;
+	std::vector<Manifest> lazyManifests;
+	for (auto it = paths.begin(); it != paths.end();) {
+		auto manifest = readManifest(*it);
+		if (!manifest.lazy) {
+			++it;
+			continue;
+		}
+		lazyPaths.push_back(*it);
+		lazyManifests.push_back(std::move(manifest));
+		it = paths.erase(it);
+	}
+
+	// Modules are opened and prepared in parallel, then registered one by one on the main thread
+	std::vector<std::future<Plugin>> plugins;
+	for (const auto & path : paths)
+		plugins.push_back(kengine::threadPool().runTask([&]() noexcept {
+			Plugin plugin{ path, getPluginName(path) };
+			measure(plugin.name, "dlopen", [&]() noexcept { openPlugin(path, plugin); });
+			if (plugin.load != nullptr && plugin.prepare != nullptr)
+				measure(plugin.name, PREPARE_FUNCTION, [&]() noexcept { plugin.prepare(kengine::getState()); });
+			return plugin;
+		}));
+
+	tagNewEntities("engine", {});
+
+	// Created before the plugins so that it doesn't get attributed to them
+	g_loaderID = (kengine::entities += [](kengine::Entity & e) noexcept {
+		e += kengine::functions::Execute{ [](float deltaTime) noexcept {
+			reloadChangedPlugins();
+			loadActivatedPlugins();
+		} };
+		e += WatchedFilesComponent{
+			{}, [](const char * path) noexcept {
+				if (std::find(g_changedPlugins.begin(), g_changedPlugins.end(), path) == g_changedPlugins.end())
+					g_changedPlugins.push_back(path);
+			}
+		};
+		e += PluginComponent{ "engine" };
+	}).id;
+
+	for (auto & future : plugins) {
+		const auto plugin = future.get();
+		if (plugin.load != nullptr)
+			measure(plugin.name, LOAD_FUNCTION, [&]() noexcept { loadPlugin(plugin); });
+	}
+
+	for (size_t i = 0; i < lazyPaths.size(); ++i)
+		addLazyPlugin(lazyPaths[i], lazyManifests[i]);
+}
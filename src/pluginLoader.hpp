@@ -0,0 +1,13 @@
+#pragma once
+
+#include "helpers/traceHelper.hpp"
+
+// Loads the plugins found in `directory`. Modules are opened and their optional `prepareKenginePlugin` called on the thread pool,
+// then `loadKenginePlugin` is called for each of them on the main thread.
+// Entities are tagged with a PluginComponent naming the plugin that created them,
+// those which exist before the plugins are loaded are attributed to the engine.
+// Plugins whose manifest is marked "lazy" are only loaded once one of the editors it lists is activated.
+// Modules are loaded from copies so they can be rebuilt while the editor runs: when one changes on disk,
+// the entities of its previous build are terminated and removed and the new build is loaded in their place.
+// Library loading and plugin initialization are timed by `recorder` if one is given
+void loadPlugins(const char * directory, traceHelper::Recorder * recorder = nullptr) noexcept;
@@ -1,4 +1,5 @@
 #include "helpers/registerTypeHelper.hpp"
+#include "helpers/traceHelper.hpp"
 #include "Rect.hpp"
 
 #define REGISTER_FUNC_DECL(COMP) void register##COMP##Component() noexcept;
@@ -33,10 +34,14 @@ REGISTER_FUNC_DECL(Text);
 REGISTER_FUNC_DECL(TimeModulator);
 REGISTER_FUNC_DECL(Transform);
 
-#define REGISTER_FUNC_NAME(COMP) register##COMP##Component
+#define REGISTER_FUNC_NAME(COMP) { "register" #COMP "Component", register##COMP##Component }
 
 using RegisterFunc = void(*)() noexcept;
-static const RegisterFunc funcs[] = {
+struct NamedRegisterFunc {
+	const char * name;
+	RegisterFunc func;
+};
+static const NamedRegisterFunc funcs[] = {
 	REGISTER_FUNC_NAME(Adjustable),
 	REGISTER_FUNC_NAME(Animation),
 	REGISTER_FUNC_NAME(AppearsInViewport),
@@ -68,12 +73,16 @@ static const RegisterFunc funcs[] = {
 	REGISTER_FUNC_NAME(Transform),
 };
 
-void registerTypes() noexcept {
+void registerTypes(traceHelper::Recorder * recorder) noexcept {
 	kengine::registerTypes<
 		putils::Rect3f, putils::Point3f,
 		putils::Color, putils::NormalizedColor
 	>();
 
-	for (const auto f : funcs)
-		f();
+	for (const auto & [name, func] : funcs) {
+		if (recorder != nullptr)
+			recorder->measure(name, "registerTypes", func);
+		else
+			func();
+	}
 }
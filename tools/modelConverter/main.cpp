@@ -0,0 +1,292 @@
+#include <thread>
+#include <chrono>
+#include <future>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "kengine.hpp"
+
+#include "data/NameComponent.hpp"
+#include "meta/LoadFromJSON.hpp"
+#include "meta/SaveToJSON.hpp"
+#include "meta/ToSave.hpp"
+
+#include "helpers/jsonHelper.hpp"
+#include "helpers/importCacheHelper.hpp"
+#include "helpers/modelFileHelper.hpp"
+#include "helpers/traceHelper.hpp"
+
+// Converts and validates models without a window: .json/.kmodel descriptions are instantiated and saved
+// in the requested format, other formats are cooked through the import cache. Per-file timings are reported as JSON
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct Input {
+	std::string path;
+	fs::path relative; // Mirrored in the output directory: relative to the directory it was found in, or only the file name
+};
+
+struct Options {
+	std::string format = "kmodel";
+	fs::path outputDirectory = ".";
+	std::string reportFile;
+	size_t cacheSize = (size_t)2048 * 1024 * 1024;
+	std::vector<Input> inputs;
+};
+
+struct FileReport {
+	std::string input;
+	std::string output;
+	std::string error;
+	float readMs = 0.f;
+	float validateMs = 0.f;
+	float writeMs = 0.f;
+};
+
+struct ReadResult {
+	std::optional<putils::json> description;
+	std::optional<std::string> cooked;
+	std::string error;
+	float ms = 0.f;
+};
+
+struct WriteResult {
+	std::string error;
+	float ms = 0.f;
+};
+
+static float msSince(Clock::time_point start) noexcept {
+	return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+static void printUsage(const char * exe) noexcept {
+	std::cerr << "Usage: " << exe << " [--format json|kmodel] [--output <dir>] [--report <file>] [--cache-size <MB>] <files or directories...>" << std::endl;
+}
+
+static std::optional<Options> parseOptions(int ac, char ** av) noexcept {
+	Options options;
+
+	for (int i = 1; i < ac; ++i) {
+		const std::string_view arg = av[i];
+		const auto hasValue = i + 1 < ac;
+
+		if (arg == "--format" && hasValue)
+			options.format = av[++i];
+		else if (arg == "--output" && hasValue)
+			options.outputDirectory = av[++i];
+		else if (arg == "--report" && hasValue)
+			options.reportFile = av[++i];
+		else if (arg == "--cache-size" && hasValue)
+			options.cacheSize = (size_t)std::max(std::atoi(av[++i]), 0) * 1024 * 1024;
+		else if (arg.starts_with("--"))
+			return std::nullopt;
+		else {
+			std::error_code error;
+			if (fs::is_directory(arg, error)) {
+				for (const auto & entry : fs::recursive_directory_iterator(arg, error))
+					if (entry.is_regular_file(error))
+						options.inputs.push_back({ entry.path().string(), entry.path().lexically_relative(arg) });
+			}
+			else
+				options.inputs.push_back({ std::string(arg), fs::path(arg).filename() });
+		}
+	}
+
+	if (options.inputs.empty() || (options.format != "json" && options.format != "kmodel"))
+		return std::nullopt;
+	return options;
+}
+
+// Runs on the thread pool
+static ReadResult read(const std::string & input, const std::unordered_set<std::string> & knownTypes, size_t cacheSize) noexcept {
+	const auto start = Clock::now();
+	ReadResult ret;
+
+	if (modelFileHelper::isModelDescription(input)) {
+		ret.description = modelFileHelper::readDescription(input.c_str());
+		if (!ret.description || !ret.description->is_object()) {
+			ret.description = std::nullopt;
+			ret.error = "Not a valid model description";
+		}
+		else
+			for (const auto & [name, _] : ret.description->items())
+				if (!knownTypes.contains(name)) {
+					ret.error = "Unknown component '" + name + "'";
+					ret.description = std::nullopt;
+					break;
+				}
+	}
+	else if (importCacheHelper::isCacheable(input)) {
+		ret.cooked = importCacheHelper::getCachedImport(input.c_str(), cacheSize);
+		if (!ret.cooked)
+			ret.error = "Import failed";
+	}
+	else
+		ret.error = "Unsupported format";
+
+	ret.ms = msSince(start);
+	return ret;
+}
+
+static bool createParentDirectory(const fs::path & output, WriteResult & result) noexcept {
+	std::error_code error;
+	fs::create_directories(output.parent_path(), error);
+	if (error)
+		result.error = error.message();
+	return !error;
+}
+
+// Runs on the thread pool
+static WriteResult write(const putils::json & description, const fs::path & output) noexcept {
+	const auto start = Clock::now();
+	WriteResult ret;
+	if (!createParentDirectory(output, ret))
+		return ret;
+	if (!modelFileHelper::writeDescription(output.string().c_str(), description))
+		ret.error = "Could not write output";
+	ret.ms = msSince(start);
+	return ret;
+}
+
+// Runs on the thread pool
+static WriteResult copy(const std::string & cooked, const fs::path & output) noexcept {
+	const auto start = Clock::now();
+	WriteResult ret;
+	if (!createParentDirectory(output, ret))
+		return ret;
+	std::error_code error;
+	fs::copy_file(cooked, output, fs::copy_options::overwrite_existing, error);
+	if (error)
+		ret.error = error.message();
+	ret.ms = msSince(start);
+	return ret;
+}
+
+int main(int ac, char ** av) {
+	const auto options = parseOptions(ac, av);
+	if (!options) {
+		printUsage(av[0]);
+		return 1;
+	}
+
+	const auto start = Clock::now();
+
+	kengine::init(std::thread::hardware_concurrency());
+
+	extern void registerTypes(traceHelper::Recorder * recorder) noexcept;
+	registerTypes(nullptr);
+
+	// Save every component found in the inputs, not only those tagged by the editor plugins
+	std::unordered_set<std::string> knownTypes;
+	for (auto [e, name, load, save] : kengine::entities.with<kengine::NameComponent, kengine::meta::LoadFromJSON, kengine::meta::SaveToJSON>()) {
+		knownTypes.insert(name.name.c_str());
+		e += ::meta::ToSave{};
+	}
+
+	const auto inputCount = options->inputs.size();
+	std::vector<FileReport> reports(inputCount);
+	std::vector<std::future<ReadResult>> reads(inputCount);
+	std::vector<std::future<WriteResult>> writes(inputCount);
+
+	// Reads and writes are submitted as a sliding window, so that only a bounded number of descriptions is held in memory
+	const auto maxInFlight = (size_t)std::max(std::thread::hardware_concurrency(), 1u) * 2;
+	const auto startRead = [&](size_t i) noexcept {
+		if (i < inputCount)
+			reads[i] = kengine::threadPool().runTask([&, i]() noexcept {
+				return read(options->inputs[i].path, knownTypes, options->cacheSize);
+			});
+	};
+	const auto finishWrite = [&](size_t i) noexcept {
+		if (!writes[i].valid())
+			return;
+		const auto result = writes[i].get();
+		reports[i].writeMs = result.ms;
+		reports[i].error = result.error;
+	};
+
+	for (size_t i = 0; i < maxInFlight; ++i)
+		startRead(i);
+
+	// Inputs with the same relative path would be written to the same output
+	std::unordered_map<std::string, size_t> outputs;
+
+	// Entities are instantiated on the main thread, reading and writing happen in parallel
+	for (size_t i = 0; i < inputCount; ++i) {
+		const auto & input = options->inputs[i];
+		auto & report = reports[i];
+		report.input = input.path;
+
+		const auto result = reads[i].get();
+		startRead(i + maxInFlight);
+		if (i >= maxInFlight)
+			finishWrite(i - maxInFlight);
+
+		report.readMs = result.ms;
+		report.error = result.error;
+		if (!result.description && !result.cooked)
+			continue;
+
+		auto output = options->outputDirectory / input.relative;
+		output.replace_extension(result.description ? '.' + options->format : fs::path(*result.cooked).extension().string());
+		report.output = output.string();
+
+		const auto [previous, inserted] = outputs.emplace(output.lexically_normal().string(), i);
+		if (!inserted) {
+			report.error = "Output collides with that of '" + options->inputs[previous->second].path + "'";
+			continue;
+		}
+
+		if (result.description) {
+			const auto validateStart = Clock::now();
+			const auto e = kengine::jsonHelper::createEntity(*result.description);
+			auto saved = modelFileHelper::saveToJSON(e);
+			kengine::entities -= e;
+			report.validateMs = msSince(validateStart);
+
+			writes[i] = kengine::threadPool().runTask([saved = std::move(saved), output]() noexcept {
+				return write(saved, output);
+			});
+		}
+		else
+			writes[i] = kengine::threadPool().runTask([cooked = *result.cooked, output]() noexcept {
+				return copy(cooked, output);
+			});
+	}
+
+	putils::json reportJSON;
+	size_t failures = 0;
+	for (size_t i = 0; i < reports.size(); ++i) {
+		auto & report = reports[i];
+		finishWrite(i);
+
+		if (!report.error.empty())
+			++failures;
+
+		reportJSON["files"].push_back({
+			{ "input", report.input },
+			{ "output", report.output },
+			{ "success", report.error.empty() },
+			{ "error", report.error },
+			{ "readMs", report.readMs },
+			{ "validateMs", report.validateMs },
+			{ "writeMs", report.writeMs },
+			{ "totalMs", report.readMs + report.validateMs + report.writeMs }
+		});
+	}
+
+	reportJSON["failures"] = failures;
+	reportJSON["totalMs"] = msSince(start);
+
+	if (options->reportFile.empty())
+		std::cout << reportJSON.dump(4) << std::endl;
+	else
+		std::ofstream(options->reportFile) << reportJSON.dump(4);
+
+	kengine::terminate();
+
+	return failures == 0 ? 0 : 1;
+}